@@ -86,19 +86,26 @@ void delete_CS8(uint8_t file_sample);
 void delete_JSON(uint8_t file_json);
 
 /**
- * @brief Carga las frecuencias y anchos de banda de un archivo CSV correspondiente a una banda seleccionada.
+ * @brief Carga las frecuencias y anchos de banda de una banda seleccionada.
  * 
- * Esta función carga los valores de frecuencias y anchos de banda desde un archivo CSV, el cual depende de la banda seleccionada.
- * Los datos se almacenan en dos arreglos proporcionados como parámetros.
+ * Los valores salen del registro en memoria de `band_plan.h` (bands/<banda>.csv leído una sola vez),
+ * así que la llamada no toca el sistema de archivos. Los datos se copian en los dos arreglos proporcionados.
  * 
  * @param bands La banda de frecuencias a cargar (VHF1, VHF2, UHF1, etc.).
  * @param frequencies Puntero a un arreglo donde se almacenarán las frecuencias de la banda.
  * @param bandwidths Puntero a un arreglo donde se almacenarán los anchos de banda de la banda.
  * 
- * @return El número de filas leídas desde el archivo CSV, o 0 si ocurrió un error al abrir el archivo.
+ * @return El número de canales de la banda, o 0 si la banda no existe o su CSV no se pudo leer.
  */
 int load_bands(uint8_t bands, double* frequencies, double* bandwidths);
 
+/**
+ * @brief Busca la frecuencia y la modulación de un canal TDT en Ciudades/<city>.csv.
+ * 
+ * La búsqueda es una consulta a la tabla hash de `band_plan.h`, sin abrir el CSV.
+ * 
+ * @return La frecuencia del canal, o 0 (con `*modulation = 0`) si el canal no existe.
+ */
 uint16_t load_bands_tdt(char* channel, char* city, int *modulation);
 
 /**
@@ -15,7 +15,9 @@
 #include <signal.h>
 #include "bacn_RF.h"
 #include "IQ.h"
+#include "band_plan.h"
 #include "../Drivers/bacn_gpio.h"
+#include "../main_c/libs/trace.h"
 
 /** @brief Variable para controlar la finalización del bucle principal. */
 static volatile bool do_exit = false;
@@ -74,6 +76,13 @@ int rx_callback(hackrf_transfer* transfer)
 {
 	size_t bytes_to_write;
 	size_t bytes_written;
+	static _Thread_local bool trace_named = false;
+
+	if (!trace_named) {
+		trace_thread_name("usb_rx");
+		trace_named = true;
+	}
+	trace_instant("usb_transfer");
 
 	if (file == NULL) {
 		stop_main_loop();
@@ -164,7 +173,7 @@ void sigalrm_callback_handler()
  * @return 0 si la captura se ejecuta correctamente, -1 en caso de error.
  */
 
-int getSamples(uint64_t central_freq_Rx_MHz, long samples_to_xfer_max, transceiver_mode_t transceiver_mode, uint16_t lna_gain, uint16_t vga_gain, uint16_t centralFrec_TDT, bool is_second_sample)
+static int getSamples_impl(uint64_t central_freq_Rx_MHz, long samples_to_xfer_max, transceiver_mode_t transceiver_mode, uint16_t lna_gain, uint16_t vga_gain, uint16_t centralFrec_TDT, bool is_second_sample)
 {
 	int64_t c_f = central_freq_Rx_MHz;
     int result = 0;                     // Variable para almacenar códigos de retorno
@@ -241,6 +250,10 @@ int getSamples(uint64_t central_freq_Rx_MHz, long samples_to_xfer_max, transceiv
 	signal(SIGTERM, &sigint_callback_handler);
 	signal(SIGABRT, &sigint_callback_handler);
 	signal(SIGALRM, &sigalrm_callback_handler);
+	// SIGHUP recarga el plan de bandas (bands/, Ciudades/) en vez de terminar el proceso
+	if (band_plan_install_sighup() != 0) {
+		fprintf(stderr, "band_plan_install_sighup() failed\n");
+	}
 
 	fprintf(stderr, "Device initialized\r\n");
 
@@ -380,7 +393,9 @@ int getSamples(uint64_t central_freq_Rx_MHz, long samples_to_xfer_max, transceiv
 		// 11. Espera señal (SIGALRM o interrupción del usuario)
 		// Bloquea ejecución hasta que se complete la adquisición
 		// ---------------------------------------------------------------------
+		trace_begin("stream");
 		pause();
+		trace_end("stream");
 
 		// Lee contador de bytes transferidos en este intervalo
 		byte_count_now = byte_count;
@@ -457,3 +472,17 @@ int getSamples(uint64_t central_freq_Rx_MHz, long samples_to_xfer_max, transceiv
 	fprintf(stderr, "exit\n");
 	return 0;
 }
+
+/**
+ * @brief Punto de entrada público de la captura; ver getSamples_impl.
+ *
+ * Envuelve la captura completa en un tramo "getSamples" cuando el trazado
+ * (RF_TRACE) está activo, sin importar por qué rama retorne.
+ */
+int getSamples(uint64_t central_freq_Rx_MHz, long samples_to_xfer_max, transceiver_mode_t transceiver_mode, uint16_t lna_gain, uint16_t vga_gain, uint16_t centralFrec_TDT, bool is_second_sample)
+{
+	trace_begin("getSamples");
+	int r = getSamples_impl(central_freq_Rx_MHz, samples_to_xfer_max, transceiver_mode, lna_gain, vga_gain, centralFrec_TDT, is_second_sample);
+	trace_end("getSamples");
+	return r;
+}
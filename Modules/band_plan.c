@@ -0,0 +1,456 @@
+/**
+ * @file band_plan.c
+ * @brief Registro en memoria de canalizaciones y canales TDT (ver band_plan.h).
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <signal.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "band_plan.h"
+#include "IQ.h"
+
+#define N_BANDS     (SHF2_7 + 1)
+#define LINE_LEN    128
+
+// Archivo de cada banda, en el orden de bands_t. SHF2_7 reutiliza SHF2.csv.
+static const char* const band_files[N_BANDS] = {
+    "VHF1", "VHF2", "VHF3", "VHF4",
+    "UHF1", "UHF1_2", "UHF1_3", "UHF1_4",
+    "UHF2_1", "UHF2_2", "UHF2_3", "UHF2_4", "UHF2_5", "UHF2_6", "UHF2_7",
+    "UHF2_8", "UHF2_9", "UHF2_10", "UHF2_11", "UHF2_12", "UHF2_13",
+    "UHF3", "UHF3_1", "UHF3_2", "UHF3_3", "UHF3_4", "UHF3_5",
+    "SHF1", "SHF2", "SHF2_2", "SHF2_3", "SHF2_4", "SHF2_5", "SHF2_6",
+    "SHF2",
+};
+
+typedef struct {
+    int offset;             // Primer canal en los arreglos contiguos
+    int count;
+    int bins_valid;         // La tabla de bins corresponde a `grid`
+    freq_grid_t grid;
+} band_slot_t;
+
+typedef struct {
+    char city[BAND_PLAN_KEY_LEN];
+    char channel[BAND_PLAN_KEY_LEN];
+    double freq;
+    int modulation;
+    uint32_t hash;
+} tdt_entry_t;
+
+// Archivo o directorio vigilado por mtime; exists = 0 si no estaba al cargar.
+typedef struct {
+    char* path;
+    int exists;
+    struct timespec mtime;
+    off_t size;
+} file_stamp_t;
+
+typedef struct {
+    double* centers;
+    double* bw;
+    freq_range_t* bins;
+    int n_channels;
+    band_slot_t bands[N_BANDS];
+
+    tdt_entry_t* tdt;
+    int n_tdt;
+    int32_t* index;         // Posición + 1 en `tdt`; 0 = vacío
+    uint32_t index_mask;
+
+    file_stamp_t* files;
+    int n_files;
+} plan_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static plan_t* g_plan = NULL;
+static volatile sig_atomic_t g_reload = 0;
+static time_t g_last_stat = 0;
+static char g_bands_dir[256] = BAND_PLAN_BANDS_DIR;
+static char g_cities_dir[256] = BAND_PLAN_CITIES_DIR;
+
+// ============================================================================
+// Utilidades
+// ============================================================================
+
+static void* grow(void* p, int* cap, int need, size_t elem)
+{
+    if (need <= *cap) return p;
+    int n = *cap ? *cap : 64;
+    while (n < need) n *= 2;
+    void* q = realloc(p, (size_t)n * elem);
+    if (q) *cap = n;
+    return q;
+}
+
+static char* trim(char* s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char* e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+    return s;
+}
+
+static uint32_t key_hash(const char* city, const char* channel)
+{
+    // FNV-1a sobre "ciudad\0canal"
+    uint32_t h = 2166136261u;
+    for (const char* p = city; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    h *= 16777619u;
+    for (const char* p = channel; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+    return h;
+}
+
+static int stamp_add(plan_t* p, int* cap, const char* path)
+{
+    file_stamp_t* f = grow(p->files, cap, p->n_files + 1, sizeof(file_stamp_t));
+    if (!f) return -1;
+    p->files = f;
+
+    file_stamp_t* s = &p->files[p->n_files];
+    memset(s, 0, sizeof(*s));
+    s->path = strdup(path);
+    if (!s->path) return -1;
+
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        s->exists = 1;
+        s->mtime = st.st_mtim;
+        s->size = st.st_size;
+    }
+    p->n_files++;
+    return 0;
+}
+
+static int plan_changed(const plan_t* p)
+{
+    for (int i = 0; i < p->n_files; i++) {
+        const file_stamp_t* s = &p->files[i];
+        struct stat st;
+        int exists = stat(s->path, &st) == 0;
+        if (exists != s->exists) return 1;
+        if (exists && (st.st_mtim.tv_sec != s->mtime.tv_sec ||
+                       st.st_mtim.tv_nsec != s->mtime.tv_nsec ||
+                       st.st_size != s->size)) return 1;
+    }
+    return 0;
+}
+
+static void plan_free(plan_t* p)
+{
+    if (!p) return;
+    for (int i = 0; i < p->n_files; i++) free(p->files[i].path);
+    free(p->files);
+    free(p->centers);
+    free(p->bw);
+    free(p->bins);
+    free(p->tdt);
+    free(p->index);
+    free(p);
+}
+
+// ============================================================================
+// Lectura de los CSV
+// ============================================================================
+
+// Agrega las filas "frecuencia,ancho" de un CSV de banda (la primera es el encabezado).
+static int read_band(plan_t* p, int* cap, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+
+    char line[LINE_LEN];
+    int ok = 0;
+    if (!fgets(line, sizeof(line), file)) goto cleanup;
+
+    while (fgets(line, sizeof(line), file)) {
+        char* end;
+        double f = strtod(line, &end);
+        if (end == line || *end != ',') continue;
+        char* s = end + 1;
+        double b = strtod(s, &end);
+        if (end == s) continue;
+
+        int need = p->n_channels + 1;
+        int c = *cap;
+        double* nc = grow(p->centers, &c, need, sizeof(double));
+        if (!nc) { ok = -1; goto cleanup; }
+        p->centers = nc;
+        c = *cap;
+        double* nb = grow(p->bw, &c, need, sizeof(double));
+        if (!nb) { ok = -1; goto cleanup; }
+        p->bw = nb;
+        *cap = c;
+
+        p->centers[p->n_channels] = f;
+        p->bw[p->n_channels] = b;
+        p->n_channels++;
+    }
+
+cleanup:
+    fclose(file);
+    return ok;
+}
+
+// Agrega las filas "canal,frecuencia,modulacion" de Ciudades/<city>.csv.
+static int read_city(plan_t* p, int* cap, const char* path, const char* city)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+
+    char line[LINE_LEN];
+    int ok = 0;
+    if (!fgets(line, sizeof(line), file)) goto cleanup;
+
+    while (fgets(line, sizeof(line), file)) {
+        char* save = NULL;
+        char* canal = strtok_r(line, ",", &save);
+        char* freq = strtok_r(NULL, ",", &save);
+        char* mod = strtok_r(NULL, "\n", &save);
+        if (!canal || !freq || !mod) continue;
+        canal = trim(canal);
+        if (!*canal || strlen(canal) >= BAND_PLAN_KEY_LEN) continue;
+
+        tdt_entry_t* t = grow(p->tdt, cap, p->n_tdt + 1, sizeof(tdt_entry_t));
+        if (!t) { ok = -1; goto cleanup; }
+        p->tdt = t;
+
+        tdt_entry_t* e = &p->tdt[p->n_tdt++];
+        memset(e, 0, sizeof(*e));
+        strcpy(e->city, city);
+        strcpy(e->channel, canal);
+        e->freq = atof(freq);
+        e->modulation = atoi(mod);
+        e->hash = key_hash(e->city, e->channel);
+    }
+
+cleanup:
+    fclose(file);
+    return ok;
+}
+
+static int read_cities(plan_t* p, int* stamp_cap, const char* dir)
+{
+    if (stamp_add(p, stamp_cap, dir) != 0) return -1;
+
+    DIR* d = opendir(dir);
+    if (!d) return 0;
+
+    int cap = 0;
+    int ok = 0;
+    char path[512];
+    struct dirent* ent;
+    while ((ent = readdir(d)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        if (len <= 4 || strcmp(ent->d_name + len - 4, ".csv") != 0) continue;
+        if (len - 4 >= BAND_PLAN_KEY_LEN) continue;
+
+        char city[BAND_PLAN_KEY_LEN];
+        memcpy(city, ent->d_name, len - 4);
+        city[len - 4] = '\0';
+        snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+
+        if (stamp_add(p, stamp_cap, path) != 0 || read_city(p, &cap, path, city) != 0) {
+            ok = -1;
+            break;
+        }
+    }
+    closedir(d);
+    return ok;
+}
+
+// Tabla hash de direccionamiento abierto; ante claves repetidas gana la primera fila.
+static int build_index(plan_t* p)
+{
+    uint32_t size = 16;
+    while (size < 2u * (uint32_t)p->n_tdt) size <<= 1;
+    p->index = calloc(size, sizeof(int32_t));
+    if (!p->index) return -1;
+    p->index_mask = size - 1;
+
+    for (int i = 0; i < p->n_tdt; i++) {
+        const tdt_entry_t* e = &p->tdt[i];
+        uint32_t slot = e->hash & p->index_mask;
+        for (;; slot = (slot + 1) & p->index_mask) {
+            int32_t k = p->index[slot];
+            if (k == 0) { p->index[slot] = i + 1; break; }
+            const tdt_entry_t* o = &p->tdt[k - 1];
+            if (o->hash == e->hash && !strcmp(o->city, e->city) && !strcmp(o->channel, e->channel)) break;
+        }
+    }
+    return 0;
+}
+
+static const tdt_entry_t* find_tdt(const plan_t* p, const char* city, const char* channel)
+{
+    uint32_t h = key_hash(city, channel);
+    for (uint32_t slot = h & p->index_mask;; slot = (slot + 1) & p->index_mask) {
+        int32_t k = p->index[slot];
+        if (k == 0) return NULL;
+        const tdt_entry_t* e = &p->tdt[k - 1];
+        if (e->hash == h && !strcmp(e->city, city) && !strcmp(e->channel, channel)) return e;
+    }
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+int band_plan_load(const char* bands_dir, const char* cities_dir)
+{
+    pthread_mutex_lock(&g_lock);
+    if (bands_dir) snprintf(g_bands_dir, sizeof(g_bands_dir), "%s", bands_dir);
+    if (cities_dir) snprintf(g_cities_dir, sizeof(g_cities_dir), "%s", cities_dir);
+    char bdir[sizeof(g_bands_dir)], cdir[sizeof(g_cities_dir)];
+    memcpy(bdir, g_bands_dir, sizeof(bdir));
+    memcpy(cdir, g_cities_dir, sizeof(cdir));
+    pthread_mutex_unlock(&g_lock);
+
+    plan_t* p = calloc(1, sizeof(plan_t));
+    if (!p) return -1;
+
+    int stamp_cap = 0, chan_cap = 0;
+    char path[512];
+
+    if (stamp_add(p, &stamp_cap, bdir) != 0) goto fail;
+    for (int b = 0; b < N_BANDS; b++) {
+        snprintf(path, sizeof(path), "%s/%s.csv", bdir, band_files[b]);
+        p->bands[b].offset = p->n_channels;
+        if (stamp_add(p, &stamp_cap, path) != 0 || read_band(p, &chan_cap, path) != 0) goto fail;
+        p->bands[b].count = p->n_channels - p->bands[b].offset;
+    }
+    if (p->n_channels > 0) {
+        p->bins = malloc((size_t)p->n_channels * sizeof(freq_range_t));
+        if (!p->bins) goto fail;
+    }
+
+    if (read_cities(p, &stamp_cap, cdir) != 0 || build_index(p) != 0) goto fail;
+
+    pthread_mutex_lock(&g_lock);
+    plan_t* old = g_plan;
+    g_plan = p;
+    g_last_stat = time(NULL);
+    pthread_mutex_unlock(&g_lock);
+    plan_free(old);
+    return 0;
+
+fail:
+    fprintf(stderr, "Error: no se pudo cargar el plan de bandas (%s, %s)\n", bdir, cdir);
+    plan_free(p);
+    return -1;
+}
+
+void band_plan_free(void)
+{
+    pthread_mutex_lock(&g_lock);
+    plan_t* old = g_plan;
+    g_plan = NULL;
+    pthread_mutex_unlock(&g_lock);
+    plan_free(old);
+}
+
+static void on_sighup(int sig)
+{
+    (void)sig;
+    g_reload = 1;
+}
+
+int band_plan_install_sighup(void)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sighup;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    return sigaction(SIGHUP, &sa, NULL);
+}
+
+void band_plan_request_reload(void)
+{
+    g_reload = 1;
+}
+
+void band_plan_refresh(void)
+{
+    pthread_mutex_lock(&g_lock);
+    int need = !g_plan || g_reload;
+    if (!need) {
+        time_t now = time(NULL);
+        if (now - g_last_stat >= BAND_PLAN_STAT_PERIOD_S) {
+            g_last_stat = now;
+            need = plan_changed(g_plan);
+        }
+    }
+    // Se limpia antes de recargar: un SIGHUP que llegue durante la carga
+    // vuelve a levantar la bandera y provoca otra recarga
+    if (need) g_reload = 0;
+    pthread_mutex_unlock(&g_lock);
+
+    if (need) band_plan_load(NULL, NULL);
+}
+
+int band_plan_band(int band, double* centers, double* bw, int max)
+{
+    if (band < 0 || band >= N_BANDS) return 0;
+    band_plan_refresh();
+
+    pthread_mutex_lock(&g_lock);
+    int count = 0;
+    if (g_plan) {
+        const band_slot_t* s = &g_plan->bands[band];
+        count = s->count;
+        int n = count < max ? count : max;
+        if (centers) memcpy(centers, g_plan->centers + s->offset, (size_t)n * sizeof(double));
+        if (bw) memcpy(bw, g_plan->bw + s->offset, (size_t)n * sizeof(double));
+    }
+    pthread_mutex_unlock(&g_lock);
+    return count;
+}
+
+int band_plan_bins(int band, const freq_grid_t* g, freq_range_t* out, int max)
+{
+    if (band < 0 || band >= N_BANDS || !g) return 0;
+    band_plan_refresh();
+
+    pthread_mutex_lock(&g_lock);
+    int count = 0;
+    if (g_plan) {
+        band_slot_t* s = &g_plan->bands[band];
+        count = s->count;
+        if (count > 0 && (!s->bins_valid || s->grid.f0 != g->f0 ||
+                          s->grid.df != g->df || s->grid.n != g->n)) {
+            freq_grid_channel_table(g, g_plan->centers + s->offset, g_plan->bw + s->offset,
+                                    count, g_plan->bins + s->offset);
+            s->grid = *g;
+            s->bins_valid = 1;
+        }
+        int n = count < max ? count : max;
+        if (out && n > 0) memcpy(out, g_plan->bins + s->offset, (size_t)n * sizeof(freq_range_t));
+    }
+    pthread_mutex_unlock(&g_lock);
+    return count;
+}
+
+int band_plan_tdt(const char* city, const char* channel, double* freq, int* modulation)
+{
+    if (!city || !channel) return -1;
+    band_plan_refresh();
+
+    pthread_mutex_lock(&g_lock);
+    const tdt_entry_t* e = g_plan ? find_tdt(g_plan, city, channel) : NULL;
+    if (e) {
+        if (freq) *freq = e->freq;
+        if (modulation) *modulation = e->modulation;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return e ? 0 : -1;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file band_plan.h
+ * @brief Registro en memoria de las canalizaciones (bands/<banda>.csv) y de los canales TDT por ciudad (Ciudades/<ciudad>.csv).
+ *
+ * Los CSV se leen una sola vez y quedan en arreglos contiguos: todas las bandas
+ * comparten un vector de centros y otro de anchos, con un desplazamiento por
+ * banda. Los canales TDT se indexan por (ciudad, canal) en una tabla hash, así
+ * que ninguna medición vuelve a abrir archivos para obtener metadatos.
+ *
+ * El registro se recarga cuando llega SIGHUP (ver `band_plan_install_sighup`) o
+ * cuando cambia el mtime de algún CSV; el mtime se revisa como mucho cada
+ * BAND_PLAN_STAT_PERIOD_S segundos. La recarga arma un registro nuevo y solo lo
+ * publica si se leyó completo: ante un error se sigue usando el anterior.
+ */
+
+#ifndef BAND_PLAN_H
+#define BAND_PLAN_H
+
+#include <stdint.h>
+
+#include "freq_grid.h"
+
+#define BAND_PLAN_BANDS_DIR     "bands"
+#define BAND_PLAN_CITIES_DIR    "Ciudades"
+#define BAND_PLAN_STAT_PERIOD_S 5       // Intervalo mínimo entre revisiones de mtime
+#define BAND_PLAN_KEY_LEN       32      // Largo máximo de ciudad y de canal (con el '\0')
+
+/**
+ * @brief Carga (o recarga) el registro desde los directorios indicados.
+ *
+ * Con NULL se usan BAND_PLAN_BANDS_DIR y BAND_PLAN_CITIES_DIR. Las bandas cuyo
+ * CSV no existe quedan vacías; no es un error.
+ *
+ * @return 0 si el registro quedó publicado, -1 si no se pudo leer (se conserva el anterior).
+ */
+int band_plan_load(const char* bands_dir, const char* cities_dir);
+
+/** @brief Libera el registro. Una consulta posterior lo vuelve a cargar. */
+void band_plan_free(void);
+
+/**
+ * @brief Instala el manejador de SIGHUP que marca el registro para recargar.
+ *
+ * El manejador solo levanta una bandera; la recarga ocurre en la siguiente
+ * consulta, fuera del contexto de la señal. La captura lo instala junto a sus
+ * otros manejadores de señales (ver bacn_RF.c); otro programa que use el
+ * registro debe llamarlo él mismo, o SIGHUP conserva su acción por defecto
+ * (terminar el proceso).
+ */
+int band_plan_install_sighup(void);
+
+/** @brief Marca el registro para recargar en la siguiente consulta (apto para señales). */
+void band_plan_request_reload(void);
+
+/**
+ * @brief Recarga si hubo SIGHUP o si algún CSV cambió; carga si aún no se hizo.
+ *
+ * Las consultas de abajo la llaman solas; sirve para forzar la revisión en un
+ * punto conocido del ciclo de medición.
+ */
+void band_plan_refresh(void);
+
+/**
+ * @brief Copia la canalización de una banda (enum BANDS de IQ.h).
+ *
+ * @param centers Destino de las frecuencias centrales, o NULL.
+ * @param bw      Destino de los anchos de banda, o NULL.
+ * @param max     Capacidad de los destinos.
+ *
+ * @return Número de canales de la banda (puede ser mayor que `max`; se copian
+ *         como mucho `max`), o 0 si la banda no existe o está vacía.
+ */
+int band_plan_band(int band, double* centers, double* bw, int max);
+
+/**
+ * @brief Tabla canal -> rango de bins de una banda sobre la rejilla `g`.
+ *
+ * La tabla se calcula la primera vez y queda guardada junto a la banda; se
+ * vuelve a calcular solo si cambia la rejilla o se recarga el registro.
+ *
+ * @param out Destino de `max` elementos.
+ * @return Número de canales de la banda, o 0 si no existe.
+ */
+int band_plan_bins(int band, const freq_grid_t* g, freq_range_t* out, int max);
+
+/**
+ * @brief Busca un canal TDT por ciudad y número de canal.
+ *
+ * @param freq       Frecuencia del canal tal como figura en el CSV, o NULL.
+ * @param modulation Modulación del canal, o NULL.
+ *
+ * @return 0 si el canal existe, -1 si no.
+ */
+int band_plan_tdt(const char* city, const char* channel, double* freq, int* modulation);
+
+#endif // BAND_PLAN_H
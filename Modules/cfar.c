@@ -0,0 +1,157 @@
+/**
+ * @file cfar.c
+ * @brief CA-CFAR sobre la PSD con sumas prefijas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "cfar.h"
+
+// Bin cercano a un borde: solo las celdas de entrenamiento que caen dentro de la PSD
+static unsigned char cfar_edge(const double* psd, const double* prefix, const double* factor,
+                               int n, int g, int t, int i) {
+    int l_start = i - g - t;                        // Celdas izquierdas: [l_start, l_end)
+    int l_end = i - g;
+    if (l_start < 0) l_start = 0;
+    if (l_end < 0) l_end = 0;
+    int r_start = i + g + 1;                        // Celdas derechas: [r_start, r_end)
+    int r_end = i + g + t + 1;
+    if (r_start > n) r_start = n;
+    if (r_end > n) r_end = n;
+
+    int c = (l_end - l_start) + (r_end - r_start);
+    if (c == 0) return 0;
+    double sum = (prefix[l_end] - prefix[l_start]) + (prefix[r_end] - prefix[r_start]);
+    return psd[i] > factor[c] * sum;
+}
+
+static int cfar_check_cfg(const cfar_cfg_t* cfg) {
+    if (cfg->guard < 0 || cfg->train < 1 || !(cfg->pfa > 0.0 && cfg->pfa < 1.0)) {
+        fprintf(stderr, "[CFAR] Configuración inválida (guard=%d train=%d pfa=%g)\n",
+                cfg->guard, cfg->train, cfg->pfa);
+        return -1;
+    }
+    return 0;
+}
+
+int cfar_detect(const double* psd, int n, const cfar_cfg_t* cfg, unsigned char* det) {
+    if (psd == NULL || det == NULL || cfg == NULL || n <= 0) return -1;
+    if (cfar_check_cfg(cfg) != 0) return -1;
+
+    int g = cfg->guard;
+    int t = cfg->train;
+
+    // prefix[k] = sum(psd[0..k))
+    double* prefix = malloc((size_t)(n + 1) * sizeof(double));
+    // factor[c]: umbral = factor[c] * suma de c celdas (alpha / c con alpha = c * (pfa^(-1/c) - 1))
+    double* factor = malloc((size_t)(2 * t + 1) * sizeof(double));
+    if (!prefix || !factor) {
+        free(prefix);
+        free(factor);
+        return -1;
+    }
+
+    prefix[0] = 0.0;
+    for (int i = 0; i < n; i++) {
+        prefix[i + 1] = prefix[i] + psd[i];
+    }
+    factor[0] = 0.0;
+    for (int c = 1; c <= 2 * t; c++) {
+        factor[c] = pow(cfg->pfa, -1.0 / c) - 1.0;
+    }
+
+    // Zona interior: ventanas completas a ambos lados, sin ramas
+    int lo = g + t;
+    int hi = n - g - t;         // Exclusivo
+    if (lo > n) lo = n;
+    if (hi < lo) hi = lo;
+
+    const double k = factor[2 * t];
+    const double* restrict p = prefix;
+    const double* restrict x = psd;
+    unsigned char* restrict d = det;
+    for (int i = lo; i < hi; i++) {
+        double sum = (p[i - g] - p[i - g - t]) + (p[i + g + t + 1] - p[i + g + 1]);
+        d[i] = x[i] > k * sum;
+    }
+
+    // Bordes: ventanas recortadas
+    for (int i = 0; i < lo; i++) {
+        det[i] = cfar_edge(psd, prefix, factor, n, g, t, i);
+    }
+    for (int i = hi; i < n; i++) {
+        det[i] = cfar_edge(psd, prefix, factor, n, g, t, i);
+    }
+
+    free(prefix);
+    free(factor);
+    return 0;
+}
+
+int cfar_channels(const double* psd, int n, const freq_range_t* ranges, int n_channels,
+                  const cfar_cfg_t* cfg, int* detections) {
+    if (psd == NULL || cfg == NULL || n <= 0 || n_channels < 0 ||
+        (n_channels > 0 && (ranges == NULL || detections == NULL))) {
+        return -1;
+    }
+    if (cfar_check_cfg(cfg) != 0) return -1;
+
+    // prefix[k] = sum(psd[0..k))
+    double* prefix = malloc((size_t)(n + 1) * sizeof(double));
+    if (prefix == NULL) return -1;
+    prefix[0] = 0.0;
+    for (int i = 0; i < n; i++) {
+        prefix[i + 1] = prefix[i] + psd[i];
+    }
+
+    for (int c = 0; c < n_channels; c++) {
+        int lo = ranges[c].lower;
+        int hi = ranges[c].upper;
+        int t = (hi - lo) / 2;
+        if (t < cfg->train) t = cfg->train;
+
+        // Celdas izquierdas [l_start, l_end) y derechas [r_start, r_end), recortadas a la PSD
+        int l_end = lo - cfg->guard;
+        int l_start = l_end - t;
+        if (l_end < 0) l_end = 0;
+        if (l_start < 0) l_start = 0;
+        int r_start = hi + cfg->guard;
+        int r_end = r_start + t;
+        if (r_start > n) r_start = n;
+        if (r_end > n) r_end = n;
+
+        int n_l = l_end - l_start;
+        int n_r = r_end - r_start;
+        double mean_l = n_l > 0 ? (prefix[l_end] - prefix[l_start]) / n_l : 0.0;
+        double mean_r = n_r > 0 ? (prefix[r_end] - prefix[r_start]) / n_r : 0.0;
+
+        // Lado de menor promedio; con los dos disponibles, pfa / 2 por la cota de la unión
+        int cells;
+        double mean, pfa = cfg->pfa;
+        if (n_l > 0 && n_r > 0) {
+            int left = mean_l <= mean_r;
+            cells = left ? n_l : n_r;
+            mean = left ? mean_l : mean_r;
+            pfa *= 0.5;
+        } else if (n_l > 0 || n_r > 0) {
+            cells = n_l > 0 ? n_l : n_r;
+            mean = n_l > 0 ? mean_l : mean_r;
+        } else {
+            detections[c] = 0;
+            continue;
+        }
+
+        // umbral = alpha * promedio, alpha = N (pfa^(-1/N) - 1)
+        double threshold = cells * (pow(pfa, -1.0 / cells) - 1.0) * mean;
+        int count = 0;
+        for (int i = lo; i < hi; i++) {
+            count += psd[i] > threshold;
+        }
+        detections[c] = count;
+    }
+
+    free(prefix);
+    return 0;
+}
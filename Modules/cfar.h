@@ -0,0 +1,72 @@
+/**
+ * @file cfar.h
+ * @brief Detector CFAR de celda promedio (CA-CFAR) sobre la PSD.
+ *
+ * Cada bin se compara con el promedio de sus celdas de entrenamiento a ambos
+ * lados (excluyendo las celdas de guarda), escalado para la probabilidad de
+ * falsa alarma pedida. Las sumas de entrenamiento salen de una suma prefija,
+ * así que el costo es O(n) y el lazo interior no tiene ramas.
+ *
+ * `cfar_detect` solo sirve para señales más angostas que su ventana: dentro de
+ * una señal ancha las celdas de entrenamiento también son señal y el umbral la
+ * tapa. Para decidir la ocupación de canales está `cfar_channels`, que toma la
+ * referencia de fuera de cada canal.
+ */
+
+#ifndef CFAR_H
+#define CFAR_H
+
+#include "freq_grid.h"
+
+/**
+ * @brief Configuración del detector.
+ *
+ * El factor de umbral supone estadística de ley cuadrática (ruido exponencial
+ * por bin), el caso de un solo periodograma; sobre una PSD de Welch promediada
+ * la tasa real de falsas alarmas queda por debajo de `pfa`.
+ */
+typedef struct {
+    int guard;          // Celdas de guarda a cada lado
+    int train;          // Celdas de entrenamiento a cada lado
+    double pfa;         // Probabilidad de falsa alarma por bin (0 < pfa < 1)
+    int min_bins;       // Bins detectados para declarar un canal ocupado
+} cfar_cfg_t;
+
+#define CFAR_CFG_DEFAULT { 4, 16, 1e-4, 2 }
+
+/**
+ * @brief Marca los bins que superan el umbral CFAR.
+ *
+ * En los bordes se usan solo las celdas de entrenamiento disponibles, con el
+ * factor recalculado para ese número de celdas.
+ *
+ * @param psd  PSD lineal de n bins.
+ * @param det  n valores: 1 si el bin supera el umbral, 0 si no.
+ *
+ * @return 0 si todo fue bien, -1 ante configuración inválida o falta de memoria.
+ */
+int cfar_detect(const double* psd, int n, const cfar_cfg_t* cfg, unsigned char* det);
+
+/**
+ * @brief Cuenta los bins de cada canal que superan un umbral CFAR tomado de fuera del canal.
+ *
+ * El canal [lower, upper) entero hace de guarda, más cfg->guard bins a cada
+ * lado; las celdas de entrenamiento son t = max(cfg->train, ancho / 2) bins a
+ * cada lado de esa guarda, recortadas a la PSD. Así una señal que llena el canal
+ * no entra en su propia referencia.
+ *
+ * Se usa el lado de menor promedio, para que un canal vecino ocupado no tape al
+ * canal. El factor de umbral es el de CA-CFAR con las celdas de ese lado y pfa / 2,
+ * así que la falsa alarma por bin sigue acotada por cfg->pfa. Si un lado queda
+ * fuera de la PSD se usa el otro con cfg->pfa. Con los dos vecinos ocupados el
+ * canal puede no detectarse.
+ *
+ * @param ranges      Tabla canal -> bins (ver `freq_grid_channel_table`).
+ * @param detections  n_channels valores: bins del canal sobre el umbral.
+ *
+ * @return 0 si todo fue bien, -1 ante configuración inválida o falta de memoria.
+ */
+int cfar_channels(const double* psd, int n, const freq_range_t* ranges, int n_channels,
+                  const cfar_cfg_t* cfg, int* detections);
+
+#endif // CFAR_H
@@ -0,0 +1,423 @@
+/**
+ * @file channel_metrics.c
+ * @brief Métricas por canal de una PSD, con hilos de trabajo persistentes para tablas grandes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "channel_metrics.h"
+#include "percentile.h"
+#include "noise_floor.h"
+
+// Suma prefija en doble-double: la potencia de un canal angosto es la resta de
+// dos sumas grandes y en double simple se perdería por cancelación
+typedef struct {
+    double* hi;
+    double* lo;
+} prefix_t;
+
+typedef struct {
+    const double* psd;
+    const freq_grid_t* grid;
+    const freq_range_t* ranges;
+    prefix_t prefix;
+    const double* noise_curve;
+    int use_cfar;               // out->detections ya viene llenado por cfar_channels
+    int min_bins;
+    double threshold_lin;
+    chan_metrics_t* out;
+    int first;
+    int last;               // Exclusivo
+    int failed;
+} chan_job_t;
+
+// Hilos de trabajo persistentes: se crean la primera vez que hacen falta y
+// quedan dormidos entre llamadas, así cada uno conserva su arena de percentiles.
+// El hilo llamador siempre procesa el bloque 0.
+static struct {
+    pthread_mutex_t dispatch;   // Una llamada repartida a la vez
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    pthread_t threads[CHAN_METRICS_MAX_THREADS - 1];
+    int n_workers;              // Hilos arrancados (sin contar al llamador)
+    int started;                // 1 tras el primer arranque, aunque n_workers quede en 0
+    int shutdown;
+    unsigned generation;        // Sube con cada reparto
+    int pending;                // Bloques aún en proceso
+    chan_job_t* jobs;           // jobs[1..n_workers], uno por hilo
+} pool = {
+    .dispatch = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+// =========================================================
+// RESERVA
+// =========================================================
+
+int chan_metrics_alloc(chan_metrics_t* m, int n) {
+    size_t count = (size_t)(n > 0 ? n : 1);
+    m->n = n;
+    m->power = malloc(count * sizeof(double));
+    m->peak = malloc(count * sizeof(double));
+    m->peak_bin = malloc(count * sizeof(int));
+    m->peak_freq = malloc(count * sizeof(double));
+    m->median = malloc(count * sizeof(double));
+    m->noise = malloc(count * sizeof(double));
+    m->obw = malloc(count * sizeof(double));
+    m->snr_db = malloc(count * sizeof(double));
+    m->detections = malloc(count * sizeof(int));
+    m->presence = malloc(count * sizeof(int));
+
+    if (!m->power || !m->peak || !m->peak_bin || !m->peak_freq || !m->median ||
+        !m->noise || !m->obw || !m->snr_db || !m->detections || !m->presence) {
+        chan_metrics_free(m);
+        return -1;
+    }
+    return 0;
+}
+
+void chan_metrics_free(chan_metrics_t* m) {
+    free(m->power);
+    free(m->peak);
+    free(m->peak_bin);
+    free(m->peak_freq);
+    free(m->median);
+    free(m->noise);
+    free(m->obw);
+    free(m->snr_db);
+    free(m->detections);
+    free(m->presence);
+    m->power = m->peak = m->peak_freq = m->median = m->noise = m->obw = m->snr_db = NULL;
+    m->peak_bin = m->detections = m->presence = NULL;
+    m->n = 0;
+}
+
+// =========================================================
+// SUMAS PREFIJAS
+// =========================================================
+
+// prefix[k] = sum(psd[0..k)), acumulado con TwoSum
+static int prefix_build(prefix_t* p, const double* psd, int n) {
+    p->hi = malloc((size_t)(n + 1) * sizeof(double));
+    p->lo = malloc((size_t)(n + 1) * sizeof(double));
+    if (!p->hi || !p->lo) {
+        free(p->hi);
+        free(p->lo);
+        return -1;
+    }
+
+    double s = 0.0, c = 0.0;
+    p->hi[0] = 0.0;
+    p->lo[0] = 0.0;
+    for (int i = 0; i < n; i++) {
+        double t = s + psd[i];
+        double bp = t - s;
+        c += (s - (t - bp)) + (psd[i] - bp);
+        s = t;
+        p->hi[i + 1] = s;
+        p->lo[i + 1] = c;
+    }
+    return 0;
+}
+
+static void prefix_free(prefix_t* p) {
+    free(p->hi);
+    free(p->lo);
+}
+
+// sum(psd[a..b))
+static inline double prefix_sum(const prefix_t* p, int a, int b) {
+    return (p->hi[b] - p->hi[a]) + (p->lo[b] - p->lo[a]);
+}
+
+// Menor k en (a, b] con sum(psd[a..k)) >= target; b si no se alcanza
+static int prefix_search(const prefix_t* p, int a, int b, double target) {
+    int lo = a + 1, hi = b;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (prefix_sum(p, a, mid) >= target) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// =========================================================
+// CANALES
+// =========================================================
+
+static int check_ranges(const freq_grid_t* grid, const freq_range_t* ranges, int n_channels) {
+    for (int c = 0; c < n_channels; c++) {
+        if (ranges[c].lower < 0 || ranges[c].upper > grid->n || ranges[c].lower >= grid->n ||
+            ranges[c].upper < ranges[c].lower) {
+            fprintf(stderr, "[CHAN] Canal %d fuera de la rejilla [%d, %d)\n", c, ranges[c].lower, ranges[c].upper);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void chan_worker(chan_job_t* job) {
+    const double* psd = job->psd;
+    const freq_grid_t* g = job->grid;
+    chan_metrics_t* out = job->out;
+    const double q[2] = { 0.5, CHAN_METRICS_NOISE_Q };
+    const double tail = 0.5 * (1.0 - CHAN_METRICS_OBW_FRACTION);
+
+    for (int c = job->first; c < job->last; c++) {
+        int lo = job->ranges[c].lower;
+        int hi = job->ranges[c].upper;
+
+        int peak_bin = lo;
+        double peak = psd[lo];
+        for (int i = lo + 1; i < hi; i++) {
+            if (psd[i] > peak) {
+                peak = psd[i];
+                peak_bin = i;
+            }
+        }
+
+        // Mediana y percentil de ruido: una sola selección sobre la copia del arena
+        double pq[2] = { 0.0, 0.0 };
+        if (hi > lo && percentiles(psd, lo, hi, q, 2, pq) != 0) {
+            job->failed = 1;
+            return;
+        }
+
+        // Potencia integrada y ancho de banda ocupado desde las sumas prefijas
+        double total = (hi > lo) ? prefix_sum(&job->prefix, lo, hi) : 0.0;
+        double obw = 0.0;
+        if (total > 0.0) {
+            int k_low = prefix_search(&job->prefix, lo, hi, tail * total) - 1;
+            int k_high = prefix_search(&job->prefix, lo, hi, (1.0 - tail) * total) - 1;
+            obw = (k_high - k_low + 1) * g->df;
+        }
+
+        out->power[c] = total * g->df;
+        out->peak[c] = peak;
+        out->peak_bin[c] = peak_bin;
+        out->peak_freq[c] = freq_grid_freq(g, peak_bin);
+        out->median[c] = pq[0];
+        out->noise[c] = pq[1];
+        out->obw[c] = obw;
+        out->snr_db[c] = 10.0 * log10(peak / job->noise_curve[peak_bin]);
+        if (!job->use_cfar) out->detections[c] = 0;
+        out->presence[c] = peak > job->threshold_lin &&
+                           (!job->use_cfar || out->detections[c] >= job->min_bins);
+    }
+}
+
+// =========================================================
+// HILOS DE TRABAJO
+// =========================================================
+
+static void *pool_main(void *arg) {
+    int idx = (int)(intptr_t)arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.generation == seen && !pool.shutdown) {
+            pthread_cond_wait(&pool.work, &pool.lock);
+        }
+        if (pool.shutdown) break;
+        seen = pool.generation;
+        chan_job_t* job = &pool.jobs[idx];
+        pthread_mutex_unlock(&pool.lock);
+
+        chan_worker(job);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0) pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// Arranca los hilos la primera vez; se llama con pool.dispatch tomado
+static void pool_start(void) {
+    if (pool.started) return;
+    pool.started = 1;
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int wanted = (ncpu > CHAN_METRICS_MAX_THREADS) ? CHAN_METRICS_MAX_THREADS : (ncpu > 1 ? (int)ncpu : 1);
+    for (int t = 0; t < wanted - 1; t++) {
+        if (pthread_create(&pool.threads[t], NULL, pool_main, (void*)(intptr_t)(t + 1)) != 0) {
+            fprintf(stderr, "[CHAN] No se pudo crear el hilo %d, se sigue con %d\n", t + 1, pool.n_workers);
+            break;
+        }
+        pool.n_workers++;
+    }
+}
+
+void chan_metrics_pool_shutdown(void) {
+    pthread_mutex_lock(&pool.dispatch);
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int t = 0; t < pool.n_workers; t++) {
+        pthread_join(pool.threads[t], NULL);
+    }
+    pool.n_workers = 0;
+    pool.started = 0;
+    pool.shutdown = 0;
+    pool.generation = 0;
+    pthread_mutex_unlock(&pool.dispatch);
+}
+
+// Reparte los canales entre el llamador y los hilos con cantidades de bins parecidas
+static int chan_dispatch(const chan_job_t* base, int n_channels, long total_bins) {
+    chan_job_t jobs[CHAN_METRICS_MAX_THREADS];
+    int parts = pool.n_workers + 1;
+
+    long acc = 0;
+    int c = 0;
+    for (int t = 0; t < parts; t++) {
+        jobs[t] = *base;
+        jobs[t].first = c;
+        long goal = total_bins * (t + 1) / parts;
+        while (c < n_channels && (t == parts - 1 || acc < goal)) {
+            acc += base->ranges[c].upper - base->ranges[c].lower;
+            c++;
+        }
+        jobs[t].last = c;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.jobs = jobs;
+    pool.pending = pool.n_workers;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+
+    chan_worker(&jobs[0]);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.pending > 0) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pool.jobs = NULL;
+    pthread_mutex_unlock(&pool.lock);
+
+    int failed = 0;
+    for (int t = 0; t < parts; t++) {
+        failed |= jobs[t].failed;
+    }
+    return failed;
+}
+
+// =========================================================
+// API
+// =========================================================
+
+int chan_metrics_peaks(const double* psd, const freq_grid_t* grid, const freq_range_t* ranges,
+                       int n_channels, chan_metrics_t* out) {
+    if (psd == NULL || grid == NULL || grid->n <= 0 || out == NULL ||
+        n_channels < 0 || n_channels > out->n || (n_channels > 0 && ranges == NULL)) {
+        return -1;
+    }
+    if (check_ranges(grid, ranges, n_channels) != 0) return -1;
+
+    for (int c = 0; c < n_channels; c++) {
+        int lo = ranges[c].lower;
+        int peak_bin = lo;
+        double peak = psd[lo];
+        for (int i = lo + 1; i < ranges[c].upper; i++) {
+            if (psd[i] > peak) {
+                peak = psd[i];
+                peak_bin = i;
+            }
+        }
+        out->peak[c] = peak;
+        out->peak_bin[c] = peak_bin;
+        out->peak_freq[c] = freq_grid_freq(grid, peak_bin);
+    }
+    return 0;
+}
+
+int chan_metrics_compute(const double* psd, const double* noise_curve, const freq_grid_t* grid,
+                         const freq_range_t* ranges, int n_channels,
+                         double threshold_db, const cfar_cfg_t* cfar, chan_metrics_t* out) {
+    if (psd == NULL || grid == NULL || grid->n <= 0 || out == NULL ||
+        n_channels < 0 || n_channels > out->n || (n_channels > 0 && ranges == NULL)) {
+        return -1;
+    }
+    if (check_ranges(grid, ranges, n_channels) != 0) return -1;
+    if (n_channels == 0) return 0;
+
+    chan_job_t base = {
+        .psd = psd, .grid = grid, .ranges = ranges, .out = out,
+        .threshold_lin = pow(10.0, threshold_db / 10.0),
+        .first = 0, .last = n_channels,
+    };
+    // Curva de piso de ruido, compartida por todos los canales. La ventana del
+    // mínimo se dimensiona con el canal más ancho para que no siga a la señal
+    double* own_curve = NULL;
+    if (noise_curve == NULL) {
+        int widest = 0;
+        for (int c = 0; c < n_channels; c++) {
+            if (ranges[c].upper - ranges[c].lower > widest) widest = ranges[c].upper - ranges[c].lower;
+        }
+        own_curve = malloc((size_t)grid->n * sizeof(double));
+        if (own_curve == NULL ||
+            noise_floor_curve(psd, grid->n, 0, noise_floor_span(widest, 0), own_curve) != 0) {
+            free(own_curve);
+            return -1;
+        }
+        noise_curve = own_curve;
+    }
+    base.noise_curve = noise_curve;
+
+    // Detecciones CFAR por canal, con la referencia tomada de fuera de cada canal
+    if (cfar != NULL) {
+        if (cfar_channels(psd, grid->n, ranges, n_channels, cfar, out->detections) != 0) {
+            free(own_curve);
+            return -1;
+        }
+        base.use_cfar = 1;
+        base.min_bins = cfar->min_bins;
+    }
+
+    if (prefix_build(&base.prefix, psd, grid->n) != 0) {
+        free(own_curve);
+        return -1;
+    }
+
+    // El costo por canal es proporcional a sus bins: con pocos no vale despertar
+    // a los hilos. Si otro llamador tiene los hilos ocupados, se sigue en este.
+    long total_bins = 0;
+    for (int c = 0; c < n_channels; c++) {
+        total_bins += ranges[c].upper - ranges[c].lower;
+    }
+    int failed;
+    if (total_bins >= CHAN_METRICS_PARALLEL_MIN_BINS && n_channels > 1 &&
+        pthread_mutex_trylock(&pool.dispatch) == 0) {
+        pool_start();
+        if (pool.n_workers > 0) {
+            failed = chan_dispatch(&base, n_channels, total_bins);
+        } else {
+            chan_worker(&base);
+            failed = base.failed;
+        }
+        pthread_mutex_unlock(&pool.dispatch);
+    } else {
+        chan_worker(&base);
+        failed = base.failed;
+    }
+
+    prefix_free(&base.prefix);
+    free(own_curve);
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file channel_metrics.h
+ * @brief Métricas por canal de una PSD (potencia, pico, mediana, OBW, SNR).
+ *
+ * Toma la PSD, su rejilla de frecuencias y la tabla canal -> bins de
+ * `freq_grid_channel_table`, y llena un resultado en forma de struct-of-arrays.
+ * La curva de ruido y las sumas prefijas (potencia y OBW) se calculan una vez
+ * por PSD y las detecciones CFAR una vez por canal (`cfar_channels`); después
+ * cada canal se recorre una vez para el pico y otra dentro de la selección de
+ * percentiles.
+ *
+ * Cuando los canales suman al menos CHAN_METRICS_PARALLEL_MIN_BINS bins se
+ * reparten entre hilos persistentes, que se crean en la primera llamada que los
+ * necesita y conservan su arena de percentiles entre llamadas. Medido con una
+ * PSD de 32768 bins: ~27 ns por bin de canal y ~19 us por reparto a 3 hilos,
+ * contra ~20 us por cada pthread_create + join.
+ */
+
+#ifndef CHANNEL_METRICS_H
+#define CHANNEL_METRICS_H
+
+#include "freq_grid.h"
+#include "cfar.h"
+
+#define CHAN_METRICS_PARALLEL_MIN_BINS  4096    // Bins de canal a partir de los cuales se usan hilos
+#define CHAN_METRICS_MAX_THREADS        4       // Contando al hilo llamador
+#define CHAN_METRICS_NOISE_Q            0.10    // Percentil de ruido por canal
+#define CHAN_METRICS_OBW_FRACTION       0.99    // Fracción de potencia del ancho de banda ocupado
+
+/**
+ * @brief Resultados por canal (struct-of-arrays, n elementos cada uno).
+ *
+ * Potencias en las unidades lineales de la PSD; frecuencias y anchos en las
+ * unidades de la rejilla.
+ */
+typedef struct {
+    int n;
+    double* power;          // Potencia integrada: sum(PSD) * df
+    double* peak;           // Valor máximo de la PSD
+    int*    peak_bin;
+    double* peak_freq;
+    double* median;
+    double* noise;          // Percentil CHAN_METRICS_NOISE_Q del canal
+    double* obw;            // Ancho de banda que contiene CHAN_METRICS_OBW_FRACTION de la potencia
+    double* snr_db;         // 10*log10(peak / piso de ruido en el bin del pico)
+    int*    detections;     // Bins del canal detectados por CFAR (0 sin CFAR)
+    int*    presence;       // 1 si el canal está ocupado (ver chan_metrics_compute)
+} chan_metrics_t;
+
+/** @brief Reserva los arreglos para n canales. Devuelve 0 si todo fue bien. */
+int chan_metrics_alloc(chan_metrics_t* m, int n);
+
+void chan_metrics_free(chan_metrics_t* m);
+
+/**
+ * @brief Calcula las métricas de todos los canales.
+ *
+ * Cada canal cubre los bins [lower, upper) de su rango, igual que
+ * `find_max`/`median` en `parameter()`; un rango vacío usa solo el bin `lower`
+ * como pico. La SNR se mide contra la curva de piso de ruido en el bin del pico.
+ *
+ * @param psd           PSD lineal de grid->n bins.
+ * @param noise_curve   Piso de ruido por bin (ver `noise_floor_curve`), o NULL
+ *                      para calcularlo aquí con la ventana que da
+ *                      `noise_floor_span` para el canal más ancho de la tabla.
+ * @param ranges        Tabla canal -> bins (ver `freq_grid_channel_table`).
+ * @param threshold_db  Umbral absoluto de presencia en dB.
+ * @param cfar          Configuración CFAR, o NULL. Sin CFAR un canal está
+ *                      ocupado si 10*log10(peak) > threshold_db; con CFAR además
+ *                      debe tener al menos cfar->min_bins bins sobre el umbral
+ *                      de `cfar_channels` (referencia fuera del canal), y el
+ *                      umbral absoluto queda como piso (un valor muy bajo deja
+ *                      la decisión solo al CFAR).
+ * @param out           Resultado con al menos n_channels elementos reservados.
+ *
+ * @return 0 si todo fue bien, -1 ante parámetros inválidos o falta de memoria.
+ */
+int chan_metrics_compute(const double* psd, const double* noise_curve, const freq_grid_t* grid,
+                         const freq_range_t* ranges, int n_channels,
+                         double threshold_db, const cfar_cfg_t* cfar, chan_metrics_t* out);
+
+/**
+ * @brief Solo el pico de cada canal: llena peak, peak_bin y peak_freq de `out`.
+ *
+ * Para quien no usa el resto de las métricas; no calcula curva de ruido, sumas
+ * prefijas ni percentiles, y no toca los demás campos. Mismos rangos y mismo
+ * criterio de pico que `chan_metrics_compute`.
+ *
+ * @return 0 si todo fue bien, -1 ante parámetros inválidos.
+ */
+int chan_metrics_peaks(const double* psd, const freq_grid_t* grid, const freq_range_t* ranges,
+                       int n_channels, chan_metrics_t* out);
+
+/**
+ * @brief Detiene los hilos de trabajo. Opcional: la siguiente llamada que los
+ * necesite los vuelve a crear.
+ */
+void chan_metrics_pool_shutdown(void);
+
+#endif // CHANNEL_METRICS_H
@@ -0,0 +1,49 @@
+/**
+ * @file freq_grid.c
+ * @brief Rejilla de frecuencias uniforme con búsqueda de bin en O(1).
+ */
+
+#include <stddef.h>
+#include <math.h>
+
+#include "freq_grid.h"
+
+freq_grid_t freq_grid_from_array(const double* f, int n) {
+    freq_grid_t g = { 0.0, 1.0, n };
+    if (f == NULL || n <= 0) {
+        g.n = 0;
+        return g;
+    }
+    g.f0 = f[0];
+    if (n > 1 && f[n - 1] > f[0]) {
+        g.df = (f[n - 1] - f[0]) / (n - 1);
+    }
+    return g;
+}
+
+int freq_grid_index(const freq_grid_t* g, double f) {
+    if (g->n <= 0) return 0;
+
+    // ceil(x - 0.5): redondeo al más cercano, empates hacia abajo
+    double x = ceil((f - g->f0) / g->df - 0.5);
+    if (!(x > 0.0)) return 0;           // También NaN
+    if (x >= g->n - 1) return g->n - 1;
+    return (int)x;
+}
+
+freq_range_t freq_grid_range(const freq_grid_t* g, double f_low, double f_high) {
+    freq_range_t r = { freq_grid_index(g, f_low), freq_grid_index(g, f_high) };
+    if (r.lower > r.upper) {
+        int temp = r.lower;
+        r.lower = r.upper;
+        r.upper = temp;
+    }
+    return r;
+}
+
+void freq_grid_channel_table(const freq_grid_t* g, const double* centers, const double* bw,
+                             int n_channels, freq_range_t* out) {
+    for (int i = 0; i < n_channels; i++) {
+        out[i] = freq_grid_range(g, centers[i] - bw[i] / 2, centers[i] + bw[i] / 2);
+    }
+}
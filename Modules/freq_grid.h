@@ -0,0 +1,62 @@
+/**
+ * @file freq_grid.h
+ * @brief Rejilla de frecuencias uniforme (f0, df, n) con búsqueda de bin en O(1).
+ *
+ * Los vectores de frecuencia que entrega Welch son uniformes, así que el bin más
+ * cercano a una frecuencia es round((f - f0) / df). Reemplaza los recorridos
+ * lineales de `find_closest_index` sobre 32768 frecuencias por canal.
+ */
+
+#ifndef FREQ_GRID_H
+#define FREQ_GRID_H
+
+typedef struct {
+    double f0;      // Frecuencia del bin 0
+    double df;      // Separación entre bins (> 0)
+    int n;          // Número de bins
+} freq_grid_t;
+
+/** Rango de bins [lower, upper], ambos incluidos. */
+typedef struct {
+    int lower;
+    int upper;
+} freq_range_t;
+
+/**
+ * @brief Construye la rejilla a partir de un vector de frecuencias uniforme y ascendente.
+ *
+ * df se toma de los extremos, (f[n-1] - f[0]) / (n - 1), para no arrastrar el
+ * redondeo de un solo paso.
+ */
+freq_grid_t freq_grid_from_array(const double* f, int n);
+
+/** @brief Frecuencia del bin i. */
+static inline double freq_grid_freq(const freq_grid_t* g, int i) {
+    return g->f0 + i * g->df;
+}
+
+/**
+ * @brief Índice del bin más cercano a `f`, acotado a [0, n-1].
+ *
+ * Mismo resultado que `find_closest_index` sobre el vector equivalente: en un
+ * empate exacto se queda con el índice menor.
+ */
+int freq_grid_index(const freq_grid_t* g, double f);
+
+/**
+ * @brief Rango de bins que cubre [f_low, f_high], ordenado y acotado a la rejilla.
+ */
+freq_range_t freq_grid_range(const freq_grid_t* g, double f_low, double f_high);
+
+/**
+ * @brief Tabla canal -> rango de bins para toda una canalización.
+ *
+ * El canal i cubre centers[i] ± bw[i]/2. Cuesta O(n_channels), sin depender
+ * del número de bins.
+ *
+ * @param out Arreglo de n_channels elementos.
+ */
+void freq_grid_channel_table(const freq_grid_t* g, const double* centers, const double* bw,
+                             int n_channels, freq_range_t* out);
+
+#endif // FREQ_GRID_H
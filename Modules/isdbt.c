@@ -0,0 +1,716 @@
+/**
+ * @file isdbt.c
+ * @brief Motor de medición ISDB-T: sincronismo OFDM, estimación de canal por pilotos y MER/BER/C-N.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <fftw3.h>
+
+#include "isdbt.h"
+#include "percentile.h"
+#include "tdt_functions.h"
+
+#define SP_BOOST        (4.0 / 3.0)  // Amplitud de los pilotos dispersos
+#define SP_ALPHA        0.25         // Seguimiento de canal por símbolo (EWMA sobre los SP)
+#define BPSK_KAPPA      0.6          // |sum z^2| / sum |z|^2 por encima: portadora BPSK (TMCC/AC/CP)
+#define WINDOW_BACKOFF  4            // La ventana FFT arranca L/4 antes del fin del CP
+#define DRIFT_MAX       1e-3         // Pendiente de fase máxima por símbolo (rad/portadora)
+#define TRACK_RANGE     1e-3         // Cambio de pendiente buscado entre símbolos
+#define PILOT_COHERENCE 0.3          // |sum P| / sum |P| mínimo en los SP para medir el símbolo
+
+static const int carriers_by_mode[4] = { 0, 1405, 2809, 5617 };
+static const int guard_divs[4] = { 4, 8, 16, 32 };
+
+typedef struct {
+    const complex double* iq;
+    size_t n;
+    int mode, guard_div;
+    int N, Nc, half;            // FFT, portadoras, portadora central
+    double L;                   // Guarda en muestras; a 6.5 MS/s puede ser fraccional (1/16 en modo 3: 409.5)
+    int delta;                  // Retroceso de la ventana FFT dentro del CP
+    double theta;               // Inicio (CP) del primer símbolo
+    double eps;                 // CFO fraccional, en portadoras
+    double rho;                 // Correlación normalizada del CP
+    int q;                      // CFO entero, en portadoras
+    int sp_phase;               // Símbolo m lleva SP en c % 12 == 3 * ((m + sp_phase) % 4)
+    double w, b;                // Rotación residual por símbolo y pendiente por símbolo y portadora
+    int n_sym;
+    fftw_complex *in, *out;
+    fftw_plan plan;
+    int* bin;                   // Bin FFT de cada portadora
+    complex double* ramp;       // Compensación del retroceso de la ventana
+} ofdm_t;
+
+static inline int wrap(int k, int N) {
+    k %= N;
+    return k < 0 ? k + N : k;
+}
+
+// =========================================================
+// SINCRONISMO POR PREFIJO CÍCLICO
+// =========================================================
+
+/*
+ * Sumas acumuladas de p[i] = r[i] * conj(r[i + N]) y de la energía media de
+ * ambos extremos (M + 1 valores, el primero 0). Los productos se calculan
+ * sobre los double intercalados para que el compilador vectorice el lazo;
+ * dependen solo de N, así que se reutilizan para todas las guardas.
+ */
+static void cp_products(const complex double* iq, int N, size_t M,
+                        double* restrict sr, double* restrict si, double* restrict se) {
+    const double* restrict r = (const double*)iq;
+    const double* restrict s = (const double*)(iq + N);
+    for (size_t i = 0; i < M; i++) {
+        double ar = r[2 * i], ai = r[2 * i + 1];
+        double br = s[2 * i], bi = s[2 * i + 1];
+        sr[i + 1] = ar * br + ai * bi;
+        si[i + 1] = ai * br - ar * bi;
+        se[i + 1] = 0.5 * (ar * ar + ai * ai + br * br + bi * bi);
+    }
+    sr[0] = si[0] = se[0] = 0.0;
+    for (size_t i = 1; i <= M; i++) {
+        sr[i] += sr[i - 1];
+        si[i] += si[i - 1];
+        se[i] += se[i - 1];
+    }
+}
+
+/*
+ * Correlación sobre una ventana de L muestras, plegada con el período del
+ * símbolo N + L sobre K símbolos: solo la guarda correcta mantiene alineados
+ * los picos de todos. El período puede ser fraccional; cada símbolo se pliega
+ * desde su inicio redondeado. Devuelve la correlación normalizada en el máximo.
+ */
+static double cp_fold(const double* sr, const double* si, const double* se, int N, double L, int K,
+                      double* gr, double* gi, double* ge, long* theta, double* eps) {
+    int Lw = (int)L;
+    double P = N + L;
+    int Pi = (int)P;
+    memset(gr, 0, Pi * sizeof(double));
+    memset(gi, 0, Pi * sizeof(double));
+    memset(ge, 0, Pi * sizeof(double));
+
+    for (int k = 0; k < K; k++) {
+        long base = lround(k * P);
+        const double *ar = sr + base, *ai = si + base, *ae = se + base;
+        for (int u = 0; u < Pi; u++) {
+            gr[u] += ar[u + Lw] - ar[u];
+            gi[u] += ai[u + Lw] - ai[u];
+            ge[u] += ae[u + Lw] - ae[u];
+        }
+    }
+
+    int best = 0;
+    double best_mag = -1.0;
+    for (int u = 0; u < Pi; u++) {
+        double mag = gr[u] * gr[u] + gi[u] * gi[u];
+        if (mag > best_mag) {
+            best_mag = mag;
+            best = u;
+        }
+    }
+    *theta = best;
+    *eps = -atan2(gi[best], gr[best]) / (2.0 * M_PI);
+    return ge[best] > 0.0 ? sqrt(best_mag) / ge[best] : 0.0;
+}
+
+static int fft_length(double fs, int mode) {
+    double n = fs * ISDBT_TU_MODE1 * (double)(1 << (mode - 1));
+    long r = lround(n);
+    return (fabs(n - (double)r) <= 1e-6 * n) ? (int)r : -1;
+}
+
+static void count_symbols(ofdm_t* o) {
+    double first = o->theta + o->L - o->delta;
+    double room = (double)o->n - 1.0 - first - o->N;
+    o->n_sym = room >= 0.0 ? (int)(room / (o->N + o->L)) + 1 : 0;
+}
+
+/*
+ * El plegado fija la fase del símbolo, no dónde empieza la señal: si la
+ * captura arranca antes que la transmisión, los primeros símbolos son solo
+ * ruido y arruinarían el entrenamiento. Se saltean los de energía menor a 1/4
+ * del máximo entre los primeros ISDBT_SYNC_SYMBOLS.
+ */
+static void skip_silent(ofdm_t* o) {
+    double energy[ISDBT_SYNC_SYMBOLS], emax = 0.0;
+    count_symbols(o);
+    int n = o->n_sym < ISDBT_SYNC_SYMBOLS ? o->n_sym : ISDBT_SYNC_SYMBOLS;
+    for (int m = 0; m < n; m++) {
+        long s = lround(o->theta + m * (o->N + o->L) + o->L - o->delta);
+        const double* x = (const double*)(o->iq + s);
+        double e = 0.0;
+        for (int i = 0; i < 2 * o->N; i++) e += x[i] * x[i];
+        energy[m] = e;
+        if (e > emax) emax = e;
+    }
+    int m0 = 0;
+    while (m0 < n && energy[m0] < 0.25 * emax) m0++;
+    if (m0 > 0 && m0 < n) {
+        o->theta += m0 * (o->N + o->L);
+        count_symbols(o);
+    }
+}
+
+// Prueba los modos y guardas permitidos por cfg y se queda con la mejor correlación
+static int ofdm_sync(ofdm_t* o, const isdbt_cfg_t* cfg, double fs) {
+    o->rho = 0.0;
+    for (int mode = 1; mode <= 3; mode++) {
+        if (cfg->mode && cfg->mode != mode) continue;
+        int N = fft_length(fs, mode);
+        if (N <= 0 || N < carriers_by_mode[mode] || (size_t)N >= o->n) continue;
+
+        size_t M = (size_t)ISDBT_SYNC_SYMBOLS * (N + N / 4) + N / 4;
+        if (M > o->n - N) M = o->n - N;
+        size_t Pmax = (size_t)(N + N / 4);
+
+        double* buf = malloc((3 * (M + 1) + 3 * Pmax) * sizeof(double));
+        if (!buf) return -1;
+        double *sr = buf, *si = sr + M + 1, *se = si + M + 1;
+        double *gr = se + M + 1, *gi = gr + Pmax, *ge = gi + Pmax;
+        cp_products(o->iq, N, M, sr, si, se);
+
+        for (int g = 0; g < 4; g++) {
+            if (cfg->guard_div && cfg->guard_div != guard_divs[g]) continue;
+            double L = (double)N / guard_divs[g];
+            long K = (long)(((double)M - L - 1.0) / (N + L));
+            if (K > ISDBT_SYNC_SYMBOLS) K = ISDBT_SYNC_SYMBOLS;
+            if (K < 2) continue;
+
+            long theta;
+            double eps;
+            double rho = cp_fold(sr, si, se, N, L, (int)K, gr, gi, ge, &theta, &eps);
+            if (rho > o->rho) {
+                o->rho = rho;
+                o->mode = mode;
+                o->guard_div = guard_divs[g];
+                o->N = N;
+                o->L = L;
+                o->theta = theta;
+                o->eps = eps;
+            }
+        }
+        free(buf);
+    }
+    if (o->rho <= 0.0) return -1;
+
+    o->Nc = carriers_by_mode[o->mode];
+    o->half = (o->Nc - 1) / 2;
+    o->delta = (int)(o->L / WINDOW_BACKOFF);
+    skip_silent(o);
+    return 0;
+}
+
+// =========================================================
+// FFT POR SÍMBOLO
+// =========================================================
+
+/*
+ * Inicio de la ventana FFT del símbolo m. Con guarda fraccional se redondea a
+ * la muestra más cercana y el resto (en muestras) se compensa en frecuencia.
+ */
+static long sym_window(const ofdm_t* o, int m, double* frac) {
+    double t = o->theta + m * (o->N + o->L) + o->L - o->delta;
+    long s = lround(t);
+    *frac = t - (double)s;
+    return s;
+}
+
+// Ventana del símbolo m con el CFO fraccional corregido; deja el espectro en o->out
+static void ofdm_fft(ofdm_t* o, int m) {
+    double frac;
+    long s = sym_window(o, m, &frac);
+    double w = -2.0 * M_PI * o->eps / o->N;
+    complex double rot = cexp(I * w * (double)s);
+    complex double inc = cexp(I * w);
+    const complex double* x = o->iq + s;
+    for (int i = 0; i < o->N; i++) {
+        o->in[i] = x[i] * rot;
+        rot *= inc;
+    }
+    fftw_execute(o->plan);
+}
+
+static void ofdm_map(ofdm_t* o) {
+    for (int c = 0; c < o->Nc; c++) {
+        int k = c - o->half + o->q;
+        o->bin[c] = wrap(k, o->N);
+        o->ramp[c] = cexp(I * 2.0 * M_PI * (double)k * o->delta / o->N);
+    }
+}
+
+/*
+ * Portadoras del símbolo m. El CFO entero se resolvió eligiendo bins, así que
+ * falta su fase en el inicio de la ventana (2 pi q s / N, distinta en cada
+ * símbolo salvo que q * L / N sea entero); con guarda fraccional también se
+ * compensa el resto del redondeo de la ventana.
+ */
+static void ofdm_carriers(const ofdm_t* o, int m, const complex double* spec, complex double* y) {
+    double frac;
+    long s = sym_window(o, m, &frac);
+    long qs = ((long)o->q * (s % o->N)) % o->N;
+    complex double rot = cexp(I * 2.0 * M_PI * (frac * (o->q - o->half) - (double)qs) / o->N);
+    complex double inc = cexp(I * 2.0 * M_PI * frac / o->N);
+    for (int c = 0; c < o->Nc; c++) {
+        y[c] = spec[o->bin[c]] * o->ramp[c] * rot;
+        rot *= inc;
+    }
+}
+
+// =========================================================
+// CFO ENTERO Y FASE DEL PATRÓN DE PILOTOS
+// =========================================================
+
+// Desplazamiento que maximiza la energía en una ventana de Nc portadoras
+static int find_int_offset(const double* pw, int N, int Nc) {
+    int half = (Nc - 1) / 2, Q = (N - Nc) / 2;
+    double E = 0.0;
+    for (int k = -half - Q; k <= half - Q; k++) E += pw[wrap(k, N)];
+
+    double best = E;
+    int best_q = -Q;
+    for (int q = -Q + 1; q <= Q; q++) {
+        E += pw[wrap(half + q, N)] - pw[wrap(-half + q - 1, N)];
+        if (E > best) {
+            best = E;
+            best_q = q;
+        }
+    }
+    return best_q;
+}
+
+static double sp_metric(double* const pw[4], int N, int Nc, int q, int p) {
+    int half = (Nc - 1) / 2;
+    double s = 0.0;
+    for (int j = 0; j < 4; j++) {
+        for (int c = 3 * ((j + p) & 3); c < Nc; c += 12) s += pw[j][wrap(c - half + q, N)];
+    }
+    return s;
+}
+
+/*
+ * Ajusta q en +-2 portadoras alrededor del máximo de energía junto con la fase
+ * del patrón SP. Devuelve el contraste entre la mejor fase y las otras tres.
+ */
+static double find_sp_pattern(ofdm_t* o, double* const pw[4], int q0) {
+    double best = -1.0, contrast = 0.0;
+    for (int q = q0 - 2; q <= q0 + 2; q++) {
+        double m[4], sum = 0.0;
+        for (int p = 0; p < 4; p++) {
+            m[p] = sp_metric(pw, o->N, o->Nc, q, p);
+            sum += m[p];
+        }
+        for (int p = 0; p < 4; p++) {
+            if (m[p] > best) {
+                best = m[p];
+                o->q = q;
+                o->sp_phase = p;
+                double others = (sum - m[p]) / 3.0;
+                contrast = others > 0.0 ? m[p] / others : 0.0;
+            }
+        }
+    }
+    return contrast;
+}
+
+static inline int sp_first(const ofdm_t* o, int m) {
+    return 3 * ((m + o->sp_phase) & 3);
+}
+
+// =========================================================
+// CANAL
+// =========================================================
+
+/*
+ * Pendiente de fase de v[i], medido en las portadoras x0 + i * dx (relativas
+ * al centro). Primero una grilla dentro de center +- range con pasos que giran
+ * a lo sumo pi/4 en el borde de la banda, luego mínimos cuadrados sobre la
+ * fase residual. Las diferencias entre vecinos serían más simples, pero su
+ * ruido se multiplica por el largo de la banda.
+ */
+static double fit_slope(const complex double* v, int n, int x0, int dx, double center, double range) {
+    double xmax = fmax(fabs((double)x0), fabs((double)x0 + (double)(n - 1) * dx));
+    double step = (M_PI / 4.0) / fmax(xmax, 1.0);
+    int steps = (int)ceil(range / step);
+
+    double best = center, best_mag = -1.0;
+    for (int k = -steps; k <= steps; k++) {
+        double beta = center + k * step;
+        complex double acc = 0.0;
+        complex double rot = cexp(-I * beta * x0), inc = cexp(-I * beta * dx);
+        for (int i = 0; i < n; i++) {
+            acc += v[i] * rot;
+            rot *= inc;
+        }
+        double mag = creal(acc * conj(acc));
+        if (mag > best_mag) {
+            best_mag = mag;
+            best = beta;
+        }
+    }
+
+    complex double C = 0.0;
+    complex double rot = cexp(-I * best * x0), inc = cexp(-I * best * dx);
+    for (int i = 0; i < n; i++) {
+        C += v[i] * rot;
+        rot *= inc;
+    }
+    double sw = 0.0, sx = 0.0, sxx = 0.0, sy = 0.0, sxy = 0.0;
+    rot = cexp(-I * best * x0);
+    for (int i = 0; i < n; i++) {
+        complex double r = v[i] * rot;
+        rot *= inc;
+        double wt = cabs(r), x = x0 + (double)i * dx, phi = carg(r * conj(C));
+        sw += wt;
+        sx += wt * x;
+        sxx += wt * x * x;
+        sy += wt * phi;
+        sxy += wt * x * phi;
+    }
+    double den = sw * sxx - sx * sx;
+    return den > 0.0 ? best + (sw * sxy - sx * sy) / den : best;
+}
+
+/*
+ * Rotación residual y deriva de reloj de los símbolos de entrenamiento: los SP
+ * se repiten cada 4 símbolos, así que y[m+4] * conj(y[m]) en cada piloto tiene
+ * fase 4 * (w + b * (c - centro)) sin importar su signo PRBS.
+ */
+static void estimate_drift(ofdm_t* o, const complex double* ytr, int T, complex double* R) {
+    int Np = (o->Nc - 1) / 3 + 1;
+    memset(R, 0, Np * sizeof(complex double));
+    for (int m = 0; m + 4 < T; m++) {
+        const complex double* y0 = ytr + (size_t)m * o->Nc;
+        const complex double* y4 = y0 + (size_t)4 * o->Nc;
+        for (int c = sp_first(o, m); c < o->Nc; c += 12) R[c / 3] += y4[c] * conj(y0[c]);
+    }
+
+    // Fase de R: 4 * w + 4 * b * (c - centro); el rango cubre unos 130 ppm de reloj
+    o->b = fit_slope(R, Np, -o->half, 3, 0.0, 4.0 * DRIFT_MAX) / 4.0;
+
+    complex double W = 0.0;
+    for (int k = 0; k < Np; k++) W += R[k] * cexp(-I * 4.0 * o->b * (3 * k - o->half));
+    o->w = carg(W) / 4.0;
+}
+
+// Aplica la deriva del entrenamiento al símbolo m
+static void remove_drift(const ofdm_t* o, complex double* y, int m) {
+    complex double rot = cexp(-I * ((o->w - o->b * o->half) * m));
+    complex double inc = cexp(-I * o->b * m);
+    for (int c = 0; c < o->Nc; c++) {
+        y[c] *= rot;
+        rot *= inc;
+    }
+}
+
+/*
+ * Signo de cada piloto por continuidad en frecuencia: el canal varía poco
+ * entre portadoras a 3 de distancia, así que A[k] * conj(A[k-1]) tiene parte
+ * real con el signo del producto de los PRBS. Si el vecino está en un nulo se
+ * toma el anterior.
+ */
+static void recover_signs(const complex double* A, int Np, signed char* s) {
+    s[0] = 1;
+    for (int k = 1; k < Np; k++) {
+        int r = (k >= 2 && cabs(A[k - 2]) > 2.0 * cabs(A[k - 1])) ? k - 2 : k - 1;
+        s[k] = (creal(A[k] * conj(A[r])) >= 0.0) ? s[r] : (signed char)-s[r];
+    }
+}
+
+// Respuesta en todas las portadoras por interpolación lineal entre pilotos
+static void build_channel(const complex double* A, const signed char* s, int Np, complex double* H) {
+    for (int k = 0; k + 1 < Np; k++) {
+        complex double h0 = A[k] * (s[k] / SP_BOOST);
+        complex double h1 = A[k + 1] * (s[k + 1] / SP_BOOST);
+        H[3 * k] = h0;
+        H[3 * k + 1] = h0 + (h1 - h0) / 3.0;
+        H[3 * k + 2] = h0 + 2.0 * (h1 - h0) / 3.0;
+    }
+    H[3 * (Np - 1)] = A[Np - 1] * (s[Np - 1] / SP_BOOST);
+}
+
+/*
+ * Lleva el símbolo m al dominio de referencia de A: quita la deriva del
+ * entrenamiento y luego estima en los SP la pendiente de fase residual
+ * (partiendo de la del símbolo anterior, en *beta) y la ganancia compleja
+ * común. P es espacio de trabajo para los productos en los pilotos.
+ *
+ * Devuelve -1 si los pilotos no se parecen a la referencia (símbolo sin
+ * señal o con una ráfaga de interferencia); ese símbolo no se mide.
+ */
+static int track_symbol(const ofdm_t* o, complex double* y, int m, const complex double* A,
+                         double* beta, complex double* P) {
+    remove_drift(o, y, m);
+
+    int c0 = sp_first(o, m), np = 0;
+    double ref = 0.0, mag = 0.0;
+    for (int c = c0; c < o->Nc; c += 12) {
+        P[np] = y[c] * conj(A[c / 3]);
+        ref += creal(A[c / 3] * conj(A[c / 3]));
+        mag += cabs(P[np]);
+        np++;
+    }
+    double slope = fit_slope(P, np, c0 - o->half, 12, *beta, TRACK_RANGE);
+
+    complex double G = 0.0;
+    complex double rot = cexp(-I * slope * (c0 - o->half)), inc = cexp(-I * slope * 12.0);
+    for (int i = 0; i < np; i++) {
+        G += P[i] * rot;
+        rot *= inc;
+    }
+    if (ref <= 0.0 || cabs(G) < PILOT_COHERENCE * mag) return -1;
+    G /= ref;
+    *beta = slope;
+
+    rot = cexp(I * slope * o->half) / G;
+    inc = cexp(-I * slope);
+    for (int c = 0; c < o->Nc; c++) {
+        y[c] *= rot;
+        rot *= inc;
+    }
+    return 0;
+}
+
+// =========================================================
+// DECISIÓN
+// =========================================================
+
+// y / h sin pasar por la división compleja genérica (con manejo de inf/NaN) de libgcc
+static inline complex double equalize(complex double y, complex double h) {
+    double h2 = creal(h) * creal(h) + cimag(h) * cimag(h);
+    return h2 > 0.0 ? y * conj(h) / h2 : 0.0;
+}
+
+// Punto ideal más cercano de una componente de M-QAM normalizada a potencia 1
+static inline double qam_slice(double x, double norm, double max_level) {
+    double d = 2.0 * floor(x * norm * 0.5) + 1.0;
+    if (d > max_level) d = max_level;
+    if (d < -max_level) d = -max_level;
+    return d / norm;
+}
+
+// =========================================================
+// MEDICIÓN
+// =========================================================
+
+int isdbt_measure(const complex double* iq, size_t n, double fs,
+                  const isdbt_cfg_t* cfg, isdbt_result_t* res) {
+    if (!iq || !res || fs <= 0.0) return -1;
+    memset(res, 0, sizeof(*res));
+
+    isdbt_cfg_t def = { 0, 0, 64, 0 };
+    if (!cfg) cfg = &def;
+    int M = cfg->modulation ? cfg->modulation : 64;
+    if (M != 4 && M != 16 && M != 64) {
+        fprintf(stderr, "[ISDBT] Unsupported modulation %d.\n", M);
+        return -1;
+    }
+    int max_symbols = cfg->max_symbols > 0 ? cfg->max_symbols : ISDBT_DEFAULT_SYMBOLS;
+
+    ofdm_t o = { .iq = iq, .n = n };
+    if (ofdm_sync(&o, cfg, fs) != 0) return -1;
+    res->mode = o.mode;
+    res->guard_div = o.guard_div;
+    res->cp_corr = o.rho;
+
+    int T = ISDBT_TRAIN_SYMBOLS;
+    if (o.rho < ISDBT_LOCK_MIN || o.n_sym < T + 4) return -1;
+    if (o.n_sym > max_symbols && max_symbols >= T + 4) o.n_sym = max_symbols;
+
+    int N = o.N, Nc = o.Nc, Np = (Nc - 1) / 3 + 1;
+    int ret = -1;
+
+    complex double* raw = malloc((size_t)T * N * sizeof(complex double));
+    complex double* ytr = malloc((size_t)T * Nc * sizeof(complex double));
+    complex double* y = malloc(Nc * sizeof(complex double));
+    complex double* H = malloc(Nc * sizeof(complex double));
+    complex double* A = calloc(Np, sizeof(complex double));
+    complex double* sp = malloc(Np * sizeof(complex double));
+    signed char* sgn = malloc(Np);
+    double* pw = calloc((size_t)4 * N, sizeof(double));
+    double* acc = calloc((size_t)4 * Nc, sizeof(double));   // |z|^2, Re/Im z^2 y luego señal/error
+    double* mer_c = malloc(Nc * sizeof(double));
+    double* ebn0 = malloc(Nc * sizeof(double));
+    double* ber_c = malloc(Nc * sizeof(double));
+    float* mod_c = malloc(Nc * sizeof(float));
+    int* cnt = calloc(Nc, sizeof(int));
+    unsigned char* is_data = malloc(Nc);
+    o.bin = malloc(Nc * sizeof(int));
+    o.ramp = malloc(Nc * sizeof(complex double));
+    o.in = fftw_alloc_complex(N);
+    o.out = fftw_alloc_complex(N);
+    if (!raw || !ytr || !y || !H || !A || !sp || !sgn || !pw || !acc || !mer_c || !ebn0 || !ber_c ||
+        !mod_c || !cnt || !is_data || !o.bin || !o.ramp || !o.in || !o.out) {
+        fprintf(stderr, "[ISDBT] Memory allocation failed.\n");
+        goto cleanup;
+    }
+    o.plan = fftw_plan_dft_1d(N, o.in, o.out, FFTW_FORWARD, FFTW_ESTIMATE);
+    if (!o.plan) goto cleanup;
+
+    // Entrenamiento: espectros completos y potencia por fase del patrón SP
+    double* pwj[4] = { pw, pw + N, pw + 2 * N, pw + 3 * N };
+    for (int m = 0; m < T; m++) {
+        ofdm_fft(&o, m);
+        complex double* dst = raw + (size_t)m * N;
+        memcpy(dst, o.out, N * sizeof(complex double));
+        for (int k = 0; k < N; k++) pwj[m & 3][k] += creal(dst[k] * conj(dst[k]));
+    }
+    double* pw_tot = acc;       // 4 * Nc > N: acc todavía no se usa
+    for (int k = 0; k < N; k++) pw_tot[k] = pwj[0][k] + pwj[1][k] + pwj[2][k] + pwj[3][k];
+    int q0 = find_int_offset(pw_tot, N, Nc);
+    memset(acc, 0, (size_t)4 * Nc * sizeof(double));
+    if (find_sp_pattern(&o, pwj, q0) < ISDBT_SP_CONTRAST_MIN) goto cleanup;
+    res->cfo_hz = ((double)o.q + o.eps) * fs / N;
+
+    ofdm_map(&o);
+    for (int m = 0; m < T; m++) ofdm_carriers(&o, m, raw + (size_t)m * N, ytr + (size_t)m * Nc);
+
+    // Canal inicial: promedio de los SP con la deriva corregida
+    estimate_drift(&o, ytr, T, A);
+    memset(A, 0, Np * sizeof(complex double));
+    int* nobs = cnt;
+    for (int m = 0; m < T; m++) {
+        memcpy(y, ytr + (size_t)m * Nc, Nc * sizeof(complex double));
+        remove_drift(&o, y, m);
+        for (int c = sp_first(&o, m); c < Nc; c += 12) {
+            A[c / 3] += y[c];
+            nobs[c / 3]++;
+        }
+    }
+    for (int k = 0; k < Np; k++) {
+        if (nobs[k]) A[k] /= nobs[k];
+    }
+    memset(cnt, 0, Nc * sizeof(int));
+    recover_signs(A, Np, sgn);
+    build_channel(A, sgn, Np, H);
+
+    // Etapa 1: clasificación de portadoras BPSK (TMCC, AC, CP) sobre el entrenamiento
+    double *s1 = acc, *s2r = acc + Nc, *s2i = acc + 2 * Nc;
+    double beta = 0.0;
+    for (int m = 0; m < T; m++) {
+        memcpy(y, ytr + (size_t)m * Nc, Nc * sizeof(complex double));
+        if (track_symbol(&o, y, m, A, &beta, sp) != 0) continue;
+        int c0 = sp_first(&o, m);
+        for (int c = 0; c < Nc; c++) {
+            if (c % 12 == c0) continue;
+            complex double z = equalize(y[c], H[c]);
+            complex double z2 = z * z;
+            s1[c] += creal(z * conj(z));
+            s2r[c] += creal(z2);
+            s2i[c] += cimag(z2);
+            cnt[c]++;
+        }
+    }
+    for (int c = 0; c < Nc; c++) {
+        is_data[c] = cnt[c] > 0 && s1[c] > 0.0 &&
+                     hypot(s2r[c], s2i[c]) < BPSK_KAPPA * s1[c] && c != Nc - 1;
+    }
+    memset(acc, 0, (size_t)4 * Nc * sizeof(double));
+
+    // Etapa 2: todos los símbolos con seguimiento del canal y decisión dura
+    double norm = sqrt(2.0 * (M - 1) / 3.0);
+    double max_level = sqrt((double)M) - 1.0;
+    double *sig = acc, *err = acc + Nc;
+    double noise = 0.0;
+    long noise_n = 0;
+    int measured = 0;
+    beta = 0.0;
+    for (int m = 0; m < o.n_sym; m++) {
+        if (m < T) {
+            memcpy(y, ytr + (size_t)m * Nc, Nc * sizeof(complex double));
+        } else {
+            ofdm_fft(&o, m);
+            ofdm_carriers(&o, m, o.out, y);
+        }
+        if (track_symbol(&o, y, m, A, &beta, sp) != 0) continue;
+        measured++;
+
+        int c0 = sp_first(&o, m);
+        for (int c = 0; c < Nc; c++) {
+            if (!is_data[c] || c % 12 == c0) continue;
+            complex double z = equalize(y[c], H[c]);
+            double ir = qam_slice(creal(z), norm, max_level);
+            double ii = qam_slice(cimag(z), norm, max_level);
+            double er = creal(z) - ir, ei = cimag(z) - ii;
+            sig[c] += ir * ir + ii * ii;
+            err[c] += er * er + ei * ei;
+        }
+
+        // Los SP de este símbolo actualizan el canal; su innovación mide el ruido
+        for (int c = c0; c < Nc; c += 12) {
+            complex double d = y[c] - A[c / 3];
+            if (m >= T) {
+                noise += creal(d * conj(d));
+                noise_n++;
+            }
+            A[c / 3] += SP_ALPHA * d;
+        }
+        build_channel(A, sgn, Np, H);
+    }
+
+    double sig_tot = 0.0, err_tot = 0.0;
+    int nd = 0;
+    for (int c = 0; c < Nc; c++) {
+        if (!is_data[c] || err[c] <= 0.0) continue;
+        sig_tot += sig[c];
+        err_tot += err[c];
+        mer_c[nd] = sig[c] / err[c];
+        mod_c[nd] = (float)M;
+        nd++;
+    }
+    if (nd == 0 || err_tot <= 0.0 || noise_n == 0) goto cleanup;
+
+    res->mer_db = 10.0 * log10(sig_tot / err_tot);
+
+    // BER pre-Viterbi: Eb/N0 de cada portadora a partir de su MER
+    double ber_sum = 0.0;
+    int bits = (int)lround(log2(M));
+    for (int i = 0; i < nd; i++) ebn0[i] = mer_c[i] / bits;
+    calculate_BER_batch(ebn0, mod_c, nd, ber_c);
+    for (int i = 0; i < nd; i++) ber_sum += ber_c[i];
+    res->ber = ber_sum / nd;
+
+    for (int i = 0; i < nd; i++) mer_c[i] = 10.0 * log10(mer_c[i]);
+    const double p10 = 0.10;
+    if (percentiles(mer_c, 0, nd, &p10, 1, &res->mer_p10_db) != 0) res->mer_p10_db = res->mer_db;
+
+    // C/N: potencia del canal en las portadoras frente a la varianza de los SP.
+    // La innovación y - A de un EWMA tiene varianza 2 sigma^2 / (2 - alpha).
+    double cpow = 0.0;
+    for (int k = 0; k < Np; k++) cpow += creal(A[k] * conj(A[k]));
+    cpow /= Np * SP_BOOST * SP_BOOST;
+    double sigma2 = noise / noise_n * (1.0 - SP_ALPHA / 2.0);
+    res->cn_db = 10.0 * log10(cpow / sigma2);
+
+    res->symbols = measured;
+    res->data_carriers = nd;
+    res->locked = 1;
+    ret = 0;
+
+cleanup:
+    if (o.plan) fftw_destroy_plan(o.plan);
+    fftw_free(o.in);
+    fftw_free(o.out);
+    free(o.bin);
+    free(o.ramp);
+    free(raw);
+    free(ytr);
+    free(y);
+    free(H);
+    free(A);
+    free(sp);
+    free(sgn);
+    free(pw);
+    free(acc);
+    free(mer_c);
+    free(ebn0);
+    free(ber_c);
+    free(mod_c);
+    free(cnt);
+    free(is_data);
+    return ret;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file isdbt.h
+ * @brief Motor de medición ISDB-T: sincronismo OFDM, estimación de canal por pilotos y MER/BER/C-N.
+ *
+ * Trabaja sobre la captura IQ de `parameter_tdt` (6.5 MS/s). A esa tasa el
+ * símbolo útil del modo 3 (1008 us) mide exactamente 6552 muestras, así que
+ * una FFT de ese largo cae justo sobre las portadoras ISDB-T.
+ *
+ * Etapas:
+ *  - Sincronismo temporal y CFO fraccional por correlación del prefijo cíclico
+ *    (plegada sobre varios símbolos); con la configuración en 0 también se
+ *    detectan el modo y el intervalo de guarda.
+ *  - CFO entero por la energía en banda y el patrón de pilotos dispersos (SP).
+ *  - Estimación de canal con los SP: los SP repiten su valor cada 4 símbolos,
+ *    así que el canal se promedia sin conocer la secuencia PRBS; el signo de
+ *    cada piloto se recupera por continuidad en frecuencia. Por símbolo se
+ *    corrigen fase común, ganancia y pendiente de fase (deriva de reloj).
+ *  - Ecualización, decisión dura por portadora y MER según ETSI TR 101 290.
+ *    Las portadoras TMCC/AC/CP (BPSK) se detectan a ciegas y se excluyen.
+ *
+ * La BER es la pre-Viterbi estimada a partir de la MER de cada portadora (no
+ * hay decodificador); la C/N sale de la varianza temporal de los SP, así que no
+ * se satura por errores de decisión como la MER.
+ *
+ * Tiempo (tests/test_isdbt.c): un cuadro de 204 símbolos en modo 3 (231 ms de
+ * señal) tarda 51-58 ms en un núcleo x86 (Xeon), FFT de 6552 puntos incluidas,
+ * unas 4 veces más rápido que el tiempo real. En los nodos ARM no está medido.
+ */
+
+#ifndef ISDBT_H
+#define ISDBT_H
+
+#include <stddef.h>
+#include <complex.h>
+
+#define ISDBT_TU_MODE1          252e-6  // Duración del símbolo útil en modo 1 (s)
+#define ISDBT_DEFAULT_SYMBOLS   204     // Un cuadro OFDM
+#define ISDBT_SYNC_SYMBOLS      16      // Símbolos plegados en la correlación del CP
+#define ISDBT_TRAIN_SYMBOLS     16      // Símbolos para CFO entero, canal inicial y clasificación
+#define ISDBT_LOCK_MIN          0.3     // Correlación normalizada mínima del CP
+#define ISDBT_SP_CONTRAST_MIN   1.2     // Potencia en SP frente a otras fases del patrón
+
+typedef struct {
+    int mode;           // 1, 2 o 3; 0 = detectar
+    int guard_div;      // 4, 8, 16 o 32 (guarda = 1/guard_div); 0 = detectar
+    int modulation;     // 4 (QPSK), 16 o 64 (QAM) de las portadoras de datos
+    int max_symbols;    // Símbolos a medir; 0 = ISDBT_DEFAULT_SYMBOLS
+} isdbt_cfg_t;
+
+typedef struct {
+    int locked;         // 1 si hubo sincronismo y los pilotos se encontraron
+    int mode;
+    int guard_div;
+    int symbols;        // Símbolos medidos
+    int data_carriers;  // Portadoras usadas para la MER
+    double cp_corr;     // Correlación normalizada del CP (0 a 1)
+    double cfo_hz;      // Desvío de frecuencia total (entero + fraccional)
+    double mer_db;      // MER de todas las portadoras de datos
+    double mer_p10_db;  // Percentil 10 de la MER por portadora
+    double ber;         // BER pre-Viterbi estimada
+    double cn_db;       // C/N por varianza de los pilotos
+} isdbt_result_t;
+
+/**
+ * @brief Mide MER, BER y C/N de una señal ISDB-T.
+ *
+ * @param iq   Muestras complejas centradas en el canal.
+ * @param fs   Tasa de muestreo; fs * 1008 us debe ser entero (6.5 MS/s, 8.126984 MS/s...).
+ * @param cfg  Configuración, o NULL para detectar modo y guarda con 64-QAM.
+ * @param res  Resultado; con res->locked = 0 los valores de medición no son válidos.
+ *
+ * @return 0 si hubo sincronismo, -1 si no (o ante parámetros inválidos).
+ */
+int isdbt_measure(const complex double* iq, size_t n, double fs,
+                  const isdbt_cfg_t* cfg, isdbt_result_t* res);
+
+#endif // ISDBT_H
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include "moda.h"
+#include "percentile.h"
 
 double find_min(double *array, size_t size) {
     double min = 1000; // Inicializamos con el máximo valor posible para double
@@ -24,6 +25,15 @@ double find_max(double *array, int lower_index, int upper_index) {
     return max;
 }
 
+double median(double* array, int start, int end) {
+    // Selección en O(n) sobre el arena del hilo (ver percentile.h)
+    const double q_median = 0.5;
+    double med = 0.0;
+    if (end > start && percentiles(array, start, end, &q_median, 1, &med) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    return med;
+}
 
 // Función para hacer slicing
 double* slice(double* array, int lower_index, int upper_index) {
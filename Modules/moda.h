@@ -11,6 +11,10 @@ double find_min(double *array, size_t size);
 
 double find_max(double *array, int lower_index, int upper_index);
 
+// Mediana de array[start, end) por selección; no modifica el original.
+// Para varios percentiles del mismo rango usar percentiles() (percentile.h)
+double median(double* array, int start, int end);
+
 // Function prototype for calculating the mode
 double calculate_mode(double data[], int size);
 
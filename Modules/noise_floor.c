@@ -0,0 +1,85 @@
+/**
+ * @file noise_floor.c
+ * @brief Piso de ruido por bin: medianas por bloque, mínimo deslizante e interpolación.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "noise_floor.h"
+#include "percentile.h"
+
+int noise_floor_curve(const double* psd, int n, int block, int span, double* out) {
+    if (psd == NULL || out == NULL || n <= 0) return -1;
+    if (block <= 0) block = NOISE_FLOOR_BLOCK;
+    if (span <= 0) span = NOISE_FLOOR_SPAN;
+    if (block > n) block = n;
+
+    int m = (n + block - 1) / block;
+    int half = span / 2;
+
+    double* med = malloc((size_t)m * sizeof(double));
+    double* floor_b = malloc((size_t)m * sizeof(double));
+    int* deque = malloc((size_t)m * sizeof(int));
+    if (!med || !floor_b || !deque) {
+        free(med);
+        free(floor_b);
+        free(deque);
+        return -1;
+    }
+
+    // Mediana de cada bloque (el último puede ser más corto)
+    const double q_median = 0.5;
+    for (int b = 0; b < m; b++) {
+        int start = b * block;
+        int end = (start + block < n) ? start + block : n;
+        if (percentiles(psd, start, end, &q_median, 1, &med[b]) != 0) {
+            free(med);
+            free(floor_b);
+            free(deque);
+            return -1;
+        }
+    }
+
+    // Mínimo de med[b-half .. b+half] con una cola monótona (índices con valores crecientes)
+    int head = 0, tail = 0;
+    for (int i = 0; i < m + half; i++) {
+        if (i < m) {
+            while (tail > head && med[deque[tail - 1]] >= med[i]) tail--;
+            deque[tail++] = i;
+        }
+        int c = i - half;
+        if (c < 0) continue;
+        while (deque[head] < c - half) head++;
+        floor_b[c] = med[deque[head]];
+    }
+
+    // Interpolación lineal entre los centros de bloque
+    double center0 = 0.5 * (block - 1);
+    for (int i = 0; i < n; i++) {
+        double x = (i - center0) / block;
+        if (x <= 0.0) {
+            out[i] = floor_b[0];
+        } else if (x >= m - 1) {
+            out[i] = floor_b[m - 1];
+        } else {
+            int b = (int)x;
+            double t = x - b;
+            out[i] = floor_b[b] * (1.0 - t) + floor_b[b + 1] * t;
+        }
+    }
+
+    free(med);
+    free(floor_b);
+    free(deque);
+    return 0;
+}
+
+int noise_floor_span(int widest, int block) {
+    if (block <= 0) block = NOISE_FLOOR_BLOCK;
+    if (widest < 0) widest = 0;
+
+    int half = (widest + block - 1) / block + 1;
+    int span = 2 * half + 1;
+    return (span > NOISE_FLOOR_SPAN) ? span : NOISE_FLOOR_SPAN;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file noise_floor.h
+ * @brief Estimación del piso de ruido por bin en tiempo lineal.
+ *
+ * Sustituye el mínimo de un solo bin (`find_min`) como referencia de ruido.
+ * La PSD se divide en bloques; la mediana de cada bloque descarta portadoras
+ * angostas, el mínimo deslizante entre bloques vecinos descarta señales anchas
+ * que ocupan bloques enteros, y la curva por bin se interpola linealmente entre
+ * los centros de bloque. Todo en O(n), sin ordenar.
+ *
+ * El mínimo solo descarta una señal si la ventana alcanza bins de ruido a algún
+ * lado de ella. La ventana por defecto (9 x 64 = 576 bins) sirve para señales de
+ * unos cientos de bins; con canales más anchos la curva sigue a la señal, así
+ * que la ventana se dimensiona con `noise_floor_span` a partir del canal más ancho.
+ */
+
+#ifndef NOISE_FLOOR_H
+#define NOISE_FLOOR_H
+
+#define NOISE_FLOOR_BLOCK   64      // Bins por bloque
+#define NOISE_FLOOR_SPAN    9       // Bloques en la ventana del mínimo deslizante (impar)
+
+/**
+ * @brief Calcula la curva de piso de ruido de una PSD lineal.
+ *
+ * @param psd    PSD lineal de n bins.
+ * @param block  Bins por bloque (<= 0: NOISE_FLOOR_BLOCK).
+ * @param span   Bloques de la ventana del mínimo (<= 0: NOISE_FLOOR_SPAN).
+ * @param out    n valores, en las mismas unidades que psd.
+ *
+ * @return 0 si todo fue bien, -1 ante parámetros inválidos o falta de memoria.
+ */
+int noise_floor_curve(const double* psd, int n, int block, int span, double* out);
+
+/**
+ * @brief Ventana del mínimo (en bloques) para canales de hasta `widest` bins.
+ *
+ * La ventana cubre al menos 2 * widest bins más un bloque, así que centrada en
+ * cualquier bin del canal llega a bins de fuera de él. Nunca es menor que
+ * NOISE_FLOOR_SPAN y siempre es impar. El costo de la curva no depende de la ventana.
+ *
+ * @param block Bins por bloque (<= 0: NOISE_FLOOR_BLOCK).
+ */
+int noise_floor_span(int widest, int block);
+
+#endif // NOISE_FLOOR_H
@@ -18,38 +18,27 @@
 #include "cs8_to_iq.h"
 #include "welch.h"
 #include "cJSON.h"
-#include "find_closest_index.h"
+#include "freq_grid.h"
+#include "channel_metrics.h"
 #include "save_to_file.h"
 #include "tdt_functions.h"
 #include "moda.h"
 #include "../Drivers/bacn_RTI.h"
 #include "../Drivers/bacn_gpio.h"
+#include "../main_c/libs/trace.h"
 
 extern bool program;
 
-double median(double* array, int start, int end) {
-    int length = end - start;
-    double* temp = (double*)malloc(length * sizeof(double));
-    if (temp == NULL) {
-        fprintf(stderr, "Memory allocation failed.\n");
-        exit(EXIT_FAILURE);
-    }
-    for (int i = 0; i < length; i++) {
-        temp[i] = array[start + i];
-    }
-    qsort(temp, length, sizeof(double), compare_doubles);
+// Probabilidad de falsa alarma del CFAR de presencia; 0 deja solo el umbral absoluto
+static double presence_pfa = 0.0;
 
-    double med;
-    if (length % 2 == 0) {
-        med = 0.5 * (temp[length / 2 - 1] + temp[length / 2]);
-    } else {
-        med = temp[length / 2];
-    }
-    free(temp);
-    return med;
+int parameter_set_cfar_pfa(double pfa) {
+    if (!(pfa >= 0.0 && pfa < 1.0)) return -1;
+    presence_pfa = pfa;
+    return 0;
 }
 
-void parameter(st_server *s_server, int threshold, double* canalization, double* bandwidth, int canalization_length, uint64_t central_freq, uint8_t file_sample, char* banda, char* Flow, char* Fhigh) 
+static void parameter_impl(st_server *s_server, int threshold, double* canalization, double* bandwidth, int canalization_length, uint64_t central_freq, uint8_t file_sample, char* banda, char* Flow, char* Fhigh) 
 {
     size_t num_samples;
 
@@ -63,8 +52,10 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
     
     
 
+    trace_begin("load_cs8");
     complex double* vector_IQ_0 = cargar_cs8(file_sample_str_0, &num_samples);
     complex double* vector_IQ_1 = cargar_cs8(file_sample_str_1, &num_samples);
+    trace_end("load_cs8");
 
     printf("Total samples: %lu\r\n", num_samples);
     
@@ -85,13 +76,10 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
     double* Pxx1 = NULL;
     double* f1 = NULL;
 
-    double* Pxx2 = NULL;
-    double* f2 = NULL;
     double* Pxx12 = NULL;
     double* f12 = NULL;
 
     int nperseg = 32768;
-    int presence;
     int N_f=nperseg;
 
     size_t psd_size = nperseg;
@@ -102,56 +90,26 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
     Pxx1 = (double*) malloc(psd_size1 * sizeof(double));
     f1 = (double*) malloc(psd_size1 * sizeof(double));
 
-    Pxx2 = (double*) malloc(psd_size * sizeof(double));
-    f2 = (double*) malloc(psd_size * sizeof(double));
     Pxx12 = (double*) malloc(psd_size1 * sizeof(double));
     f12 = (double*) malloc(psd_size1 * sizeof(double));
     
-    welch_psd_complex(vector_IQ_0, num_samples, 20000000, nperseg, 0, f, Pxx);
-    welch_psd_complex(vector_IQ_0, num_samples, 20000000, 4096, 0, f1, Pxx1);
+    trace_begin("welch");
+    // IQ_0 en las dos resoluciones; de IQ_1 solo se usa la PSD gruesa
+    // (corrección del pico DC)
+    welch_psd_complex_ex(vector_IQ_0, num_samples, 20000000, nperseg, 0, false, f, Pxx);
+    welch_psd_complex_ex(vector_IQ_0, num_samples, 20000000, 4096, 0, false, f1, Pxx1);
     free(vector_IQ_0);
 
-    welch_psd_complex(vector_IQ_1, num_samples, 20000000, nperseg, 0, f2, Pxx2);
-    welch_psd_complex(vector_IQ_1, num_samples, 20000000, 4096, 0, f12, Pxx12);
+    welch_psd_complex_ex(vector_IQ_1, num_samples, 20000000, 4096, 0, false, f12, Pxx12);
     free(vector_IQ_1);
+    trace_end("welch");
 
     //real_time();
     if (nperseg % 2 != 0) {
         printf("La longitud del vector debe ser par.\n");
         return;
     }
-    // -----------Acomodar potencias de welch-----------
-    int half = nperseg / 2;
-    int half1 = 2048;
-    double* temp = (double*)malloc(nperseg * sizeof(double));
-    double* temp1 = (double*)malloc(4096 * sizeof(double));
-
-    for (int i = 0; i < half; i++) {
-        temp[i] = Pxx[half + i];
-        
-    }
-
-    for (int i = 0; i < half1; i++) {
-        temp1[i] = Pxx1[half1 + i];
-        
-    }
-
-    for (int i = 0; i < half; i++) {
-        temp[half + i] = Pxx[i];
-    }
-    for (int i = 0; i < half1; i++) {
-        temp1[half1 + i] = Pxx1[i];
-    }
-
-    for (int i = 0; i < nperseg; i++) {
-        Pxx[i] = temp[i];
-    } 
-    for (int i = 0; i < 4096; i++) {
-        Pxx1[i] = temp1[i];
-    }
-
-    free(temp);
-    free(temp1);
+    // Welch en orden natural de la FFT (sin fftshift): no hace falta re-acomodar
 
     // save_to_file(f, Pxx, nperseg, "data.csv");
 
@@ -205,69 +163,12 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
 
     //--------------------------Ordenar esto plox---------------------------
 
-    int half2 = nperseg / 2;
-    int half12 = 2048;
-    double* temp2 = (double*)malloc(nperseg * sizeof(double));
-    double* temp12 = (double*)malloc(4096 * sizeof(double));
-
-    for (int i = 0; i < half2; i++) {
-        temp2[i] = Pxx2[half2 + i];
-        
-    }
-
-    for (int i = 0; i < half12; i++) {
-        temp12[i] = Pxx12[half12 + i];
-        
-    }
-
-    for (int i = 0; i < half2; i++) {
-        temp2[half2 + i] = Pxx2[i];
-    }
-    for (int i = 0; i < half12; i++) {
-        temp12[half12 + i] = Pxx12[i];
-    }
-
-    for (int i = 0; i < nperseg; i++) {
-        Pxx2[i] = temp2[i];
-    } 
-    for (int i = 0; i < 4096; i++) {
-        Pxx12[i] = temp12[i];
-    }
-
-    free(temp2);
-    free(temp12);
-
     // save_to_file(f, Pxx, nperseg, "data.csv");
 
-    for (int i = 0; i < N_f; i++) {
-        f2[i] = (f2[i] + central_freq) / 1e6;
-    }
     for (int i = 0; i < 4096; i++) {
         f12[i] = (f12[i] + central_freq) / 1e6;
     }
 
-    index = nperseg/2 ;
-    count = nperseg*0.002;
-    index1 = 2048 ;
-    count1 = 4096*0.002;
-    b=index-(count+13);
-    a=index;
-
-    for (int i=0; i<count; i++)
-    {   
-        b=b-3;
-        Pxx2[a]=Pxx2[b];
-        a=a-1;
-        
-    }
-    a=index;
-    for (int i=0; i<count; i++)
-    {   
-        Pxx2[i]=Pxx2[b];
-        a=a+1;
-        b=b-2;
-        
-    }
     a=index1;
     b=index1-(count1+5);
     for (int i=0; i<count1; i++)
@@ -287,7 +188,9 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
         
     }
 
-    bool DC_spike_success = DC_spike_correction(Pxx1, f1, Pxx12, f12);
+    freq_grid_t grid1 = freq_grid_from_array(f1, 4096);
+    freq_grid_t grid12 = freq_grid_from_array(f12, 4096);
+    bool DC_spike_success = DC_spike_correction(Pxx1, &grid1, Pxx12, &grid12);
 
     if (!DC_spike_success) {
         printf("\nError while DC_spike_correction");
@@ -333,63 +236,52 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
 
     cJSON *json_params_array = cJSON_CreateArray();
 
-    float noise = find_min(Pxx, nperseg);
-
+    trace_begin("channel_params");
     //real_time();
 
-    for (int idx = 0; idx < canalization_length; idx++) {
-        double center_freq = canalization[idx];
-        double bw = bandwidth[idx];
-
-        double target_lower_freq = center_freq - bw / 2;
-        double target_upper_freq = center_freq + bw / 2;
-
-        int lower_index = find_closest_index(f, N_f, target_lower_freq);
-        int upper_index = find_closest_index(f, N_f, target_upper_freq);
-
-
-        if (lower_index > upper_index) {
-            int temp = lower_index;
-            lower_index = upper_index;
-            upper_index = temp;
-        }
-        if (lower_index < 0) lower_index = 0;
-        if (upper_index >= N_f) upper_index = N_f - 1;
-
-        int range_length = upper_index - lower_index + 1;
-        
-        double power_max = find_max(Pxx, lower_index, upper_index);
-
-        double power = median(Pxx, lower_index, upper_index);
+    // Tabla canal -> bins de la canalización: O(1) por canal sobre la rejilla uniforme
+    freq_grid_t grid = freq_grid_from_array(f, N_f);
+    freq_range_t* ranges = (freq_range_t*) malloc((canalization_length > 0 ? canalization_length : 1) * sizeof(freq_range_t));
+    freq_grid_channel_table(&grid, canalization, bandwidth, canalization_length, ranges);
 
-        double snr = 10.0 * log10(power_max / noise );
+    // Pico, mediana, SNR y presencia de todos los canales.
+    // Presencia: 10*log10(pico) > threshold; con parameter_set_cfar_pfa además CFAR por canal
+    cfar_cfg_t cfar = CFAR_CFG_DEFAULT;
+    cfar.pfa = presence_pfa;
+    chan_metrics_t metrics;
+    if (chan_metrics_alloc(&metrics, canalization_length) != 0 ||
+        chan_metrics_compute(Pxx, NULL, &grid, ranges, canalization_length, threshold,
+                             presence_pfa > 0.0 ? &cfar : NULL, &metrics) != 0) {
+        fprintf(stderr, "Error while computing channel metrics\n");
+        metrics.n = 0;
+    }
 
-        if (10.0 * log10(power_max) > threshold){
-            presence = 1;
-        } else {
-            presence = 0;
-        }
+    for (int idx = 0; idx < metrics.n; idx++) {
+        double center_freq = canalization[idx];
 
         cJSON *json_item = cJSON_CreateObject();
         cJSON_AddNumberToObject(json_item, "freq", center_freq);
 
         memset(tempu, 0, sizeof(tempu));
-        sprintf(tempu, "%0.3f", 10.0 * log10(power));
+        sprintf(tempu, "%0.3f", 10.0 * log10(metrics.median[idx]));
         cJSON_AddNumberToObject(json_item, "power", atof(tempu));
 
         memset(tempu, 0, sizeof(tempu));
-        sprintf(tempu, "%0.3f", 10.0 * log10(power_max));        
+        sprintf(tempu, "%0.3f", 10.0 * log10(metrics.peak[idx]));        
         cJSON_AddNumberToObject(json_item, "power_max", atof(tempu));
         
         memset(tempu, 0, sizeof(tempu));
-        sprintf(tempu, "%0.3f", snr);        
+        sprintf(tempu, "%0.3f", metrics.snr_db[idx]);        
         cJSON_AddNumberToObject(json_item, "snr", atof(tempu));
 
-        cJSON_AddNumberToObject(json_item, "Presence", presence);
+        cJSON_AddNumberToObject(json_item, "Presence", metrics.presence[idx]);
 
         cJSON_AddItemToArray(json_params_array, json_item);
     }
 
+    chan_metrics_free(&metrics);
+    free(ranges);
+    trace_end("channel_params");
     //real_time();
 
     cJSON_AddItemToObject(json_root, "params", json_params_array);
@@ -413,6 +305,8 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
         free(Pxx);
         free(f1);
         free(Pxx1);
+        free(f12);
+        free(Pxx12);
         free(vector_IQ_0);
         free(vector_IQ_1);
 
@@ -438,5 +332,14 @@ void parameter(st_server *s_server, int threshold, double* canalization, double*
     free(Pxx);
     free(f1);
     free(Pxx1);
+    free(f12);
+    free(Pxx12);
     //real_time();
-}
\ No newline at end of file
+}
+
+void parameter(st_server *s_server, int threshold, double* canalization, double* bandwidth, int canalization_length, uint64_t central_freq, uint8_t file_sample, char* banda, char* Flow, char* Fhigh) 
+{
+    trace_begin("parameter");
+    parameter_impl(s_server, threshold, canalization, bandwidth, canalization_length, central_freq, file_sample, banda, Flow, Fhigh);
+    trace_end("parameter");
+}
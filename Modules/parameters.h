@@ -28,4 +28,16 @@
 
 void parameter(st_server *s_server, int threshold, double* canalisation, double* bandwidth, int canalisation_length, uint64_t central_freq, uint8_t file_sample, char* banda, char* Flow, char* Fhigh);
 
+/**
+ * @brief Elige cómo decide `parameter()` la presencia de señal en cada canal.
+ *
+ * Con pfa = 0 (por defecto) un canal está ocupado si 10*log10(pico) > threshold.
+ * Con 0 < pfa < 1 además debe tener al menos 2 bins sobre el umbral CFAR de
+ * `cfar_channels` con esa probabilidad de falsa alarma por bin. Se llama antes
+ * de empezar a medir, no en paralelo con `parameter()`.
+ *
+ * @return 0 si todo fue bien, -1 si pfa está fuera de [0, 1).
+ */
+int parameter_set_cfar_pfa(double pfa);
+
 #endif // PARAMETER_ANALYSIS_H
\ No newline at end of file
@@ -18,7 +18,8 @@
 #include "cs8_to_iq.h"
 #include "welch.h"
 #include "cJSON.h"
-#include "find_closest_index.h"
+#include "freq_grid.h"
+#include "channel_metrics.h"
 #include "save_to_file.h"
 #include "tdt_functions.h"
 #include "moda.h"
@@ -52,7 +53,6 @@ void parameter_rni(st_server *s_server, int threshold, double* canalization, dou
     double* Pxx1 = NULL;
     double* f1 = NULL;
     int nperseg = 32768;
-    int presence;
     int N_f=nperseg;
 
     size_t psd_size = nperseg;
@@ -62,51 +62,15 @@ void parameter_rni(st_server *s_server, int threshold, double* canalization, dou
     Pxx1 = (double*) malloc(psd_size1 * sizeof(double));
     f1 = (double*) malloc(psd_size1 * sizeof(double));
     
-    welch_psd_complex(vector_IQ, num_samples, 20000000, nperseg, 0, f, Pxx);
-    welch_psd_complex(vector_IQ, num_samples, 20000000, 4096, 0, f1, Pxx1);
+    welch_psd_complex_ex(vector_IQ, num_samples, 20000000, nperseg, 0, false, f, Pxx);
+    welch_psd_complex_ex(vector_IQ, num_samples, 20000000, 4096, 0, false, f1, Pxx1);
     free(vector_IQ);
 
     if (nperseg % 2 != 0) {
         printf("La longitud del vector debe ser par.\n");
         return;
     }
-    // -----------Acomodar potencias de welch-----------
-    int half = nperseg / 2;
-    int half1 =2048;
-    double* temp = (double*)malloc(nperseg * sizeof(double));
-    double* temp1 = (double*)malloc(4096 * sizeof(double));
-
-    for (int i = 0; i < half; i++) {
-        temp[i] = Pxx[half + i];
-        
-    }
-
-    for (int i = 0; i < half; i++) {
-        temp[half + i] = Pxx[i];
-    }
-
-    for (int i = 0; i < nperseg; i++) {
-        Pxx[i] = temp[i];
-    } 
-
-
-    for (int i = 0; i < half1; i++) {
-        temp1[i] = Pxx1[half1 + i];
-        
-    }
-
-
-    for (int i = 0; i < half1; i++) {
-        temp1[half1 + i] = Pxx1[i];
-    }
-
-
-    for (int i = 0; i < 4096; i++) {
-        Pxx1[i] = temp1[i];
-    }
-
-    free(temp);
-    free(temp1);
+    // Welch en orden natural de la FFT (sin fftshift): no hace falta re-acomodar
 
     // save_to_file(f, Pxx, nperseg, "data.csv");
 
@@ -198,36 +162,24 @@ void parameter_rni(st_server *s_server, int threshold, double* canalization, dou
     cJSON *json_params_array = cJSON_CreateArray();
 
 
-    float noise = find_min(Pxx, nperseg);
-
-    for (int idx = 0; idx < (canalization_length-1); idx++) {
-        double center_freq = canalization[idx];
-        double bw = bandwidth[idx];
-    
-
-        int index = find_closest_index(f, N_f, center_freq);
-
-        double target_lower_freq = center_freq - bw / 2;
-        double target_upper_freq = center_freq + bw / 2;
-
-        int lower_index = find_closest_index(f, N_f, target_lower_freq);
-        int upper_index = find_closest_index(f, N_f, target_upper_freq);
-
-        if (lower_index > upper_index) {
-            int temp = lower_index;
-            lower_index = upper_index;
-            upper_index = temp;
-        }
-
-        if (lower_index < 0) lower_index = 0;
-        if (upper_index >= N_f) upper_index = N_f - 1;
-
-        int range_length = upper_index - lower_index + 1;
+    // Tabla canal -> bins de la canalización: O(1) por canal sobre la rejilla uniforme
+    freq_grid_t grid = freq_grid_from_array(f, N_f);
+    freq_range_t* ranges = (freq_range_t*) malloc((canalization_length > 0 ? canalization_length : 1) * sizeof(freq_range_t));
+    freq_grid_channel_table(&grid, canalization, bandwidth, canalization_length, ranges);
 
+    // canalization_length es el número de canales (lo que devuelve load_bands), sin fila de encabezado
+    int n_channels = (canalization_length > 0) ? canalization_length : 0;
+    chan_metrics_t metrics;
+    if (chan_metrics_alloc(&metrics, n_channels) != 0 ||
+        chan_metrics_peaks(Pxx, &grid, ranges, n_channels, &metrics) != 0) {
+        fprintf(stderr, "Error while computing channel metrics\n");
+        metrics.n = 0;
+    }
 
-        double power_max = find_max(Pxx, lower_index, upper_index);
+    for (int idx = 0; idx < metrics.n; idx++) {
+        double center_freq = canalization[idx];
 
-        double power = median(Pxx, lower_index, upper_index);
+        double power_max = metrics.peak[idx];
         double power_vm = 10*log10(power_max);
         power_vm=pow(10, (power_vm-30.0)/10.0);
 
@@ -247,6 +199,8 @@ void parameter_rni(st_server *s_server, int threshold, double* canalization, dou
         cJSON_AddItemToArray(json_params_array, json_item);
         
     }
+    chan_metrics_free(&metrics);
+    free(ranges);
 
     cJSON_AddItemToObject(json_root, "params", json_params_array);
     
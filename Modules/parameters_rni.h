@@ -23,7 +23,7 @@
  * @param threshold Umbral de potencia máxima para determinar la presencia de una señal.
  * @param canalization Arreglo de frecuencias centrales de los canales a analizar.
  * @param bandwidth Ancho de banda de cada canal correspondiente a `canalization`.
- * @param canalization_length Número de canales a analizar.
+ * @param canalization_length Número de canales a analizar (el valor que devuelve `load_bands`); se reportan todos.
  * @param central_freq Frecuencia central de la señal (en Hz).
  * @param file_sample Archivo de entrada que contiene la señal IQ en formato CS8.
  * 
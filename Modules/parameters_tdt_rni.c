@@ -39,7 +39,7 @@ void parameter_tdt_rni(int modulation, uint64_t central_freq, uint8_t file_sampl
     
     double mer_value = 0.0, ber_value = 0.0, c_n_value = 0.0, signal_power_value;
 
-    analyze_signal(central_freq, modulation, IQ_data, num_samples, &mer_value, &ber_value, &c_n_value, &signal_power_value);
+    analyze_signal(central_freq, modulation, IQ_data, num_samples, &mer_value, &ber_value, &c_n_value, &signal_power_value, NULL);
 
     double v_m = sqrt((signal_power_value/1000)*377);
 
@@ -0,0 +1,181 @@
+/**
+ * @file percentile.c
+ * @brief Percentiles por selección (introselect) con arena por hilo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "percentile.h"
+
+#define SMALL_RANGE 16      // Por debajo, ordenamiento por inserción
+
+// =========================================================
+// ARENA POR HILO
+// =========================================================
+
+static _Thread_local double* arena = NULL;
+static _Thread_local size_t arena_cap = 0;
+
+static pthread_key_t arena_key;
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+static void arena_destructor(void* p) {
+    free(p);
+}
+
+static void arena_key_init(void) {
+    pthread_key_create(&arena_key, arena_destructor);
+}
+
+// Devuelve un buffer de al menos n doubles; crece pero no se achica
+static double* arena_get(size_t n) {
+    if (n <= arena_cap) return arena;
+
+    size_t cap = arena_cap ? arena_cap : 1024;
+    while (cap < n) cap *= 2;
+
+    double* p = realloc(arena, cap * sizeof(double));
+    if (p == NULL) return NULL;
+
+    pthread_once(&arena_once, arena_key_init);
+    pthread_setspecific(arena_key, p);
+    arena = p;
+    arena_cap = cap;
+    return p;
+}
+
+void percentile_arena_release(void) {
+    free(arena);
+    arena = NULL;
+    arena_cap = 0;
+    pthread_once(&arena_once, arena_key_init);
+    pthread_setspecific(arena_key, NULL);
+}
+
+// =========================================================
+// SELECCIÓN
+// =========================================================
+
+static int compare_doubles_asc(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void insertion_sort(double* a, int lo, int hi) {
+    for (int i = lo + 1; i <= hi; i++) {
+        double v = a[i];
+        int j = i - 1;
+        while (j >= lo && a[j] > v) {
+            a[j + 1] = a[j];
+            j--;
+        }
+        a[j + 1] = v;
+    }
+}
+
+static inline void swap_d(double* a, int i, int j) {
+    double t = a[i];
+    a[i] = a[j];
+    a[j] = t;
+}
+
+/*
+ * Deja en a[k] el k-ésimo menor de a[lo..hi], con a[lo..k-1] <= a[k] <= a[k+1..hi].
+ * Quickselect con pivote mediana de tres; si la recursión se degenera pasa a
+ * qsort del rango restante, así el peor caso queda en O(n log n).
+ */
+static void select_kth(double* a, int lo, int hi, int k) {
+    int depth = 0;
+    for (int n = hi - lo + 1; n > 1; n >>= 1) depth += 2;
+
+    while (hi > lo) {
+        if (hi - lo < SMALL_RANGE) {
+            insertion_sort(a, lo, hi);
+            return;
+        }
+        if (depth-- == 0) {
+            qsort(a + lo, (size_t)(hi - lo + 1), sizeof(double), compare_doubles_asc);
+            return;
+        }
+
+        int mid = lo + (hi - lo) / 2;
+        if (a[mid] < a[lo]) swap_d(a, mid, lo);
+        if (a[hi] < a[lo]) swap_d(a, hi, lo);
+        if (a[hi] < a[mid]) swap_d(a, hi, mid);
+        double pivot = a[mid];
+
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j) {
+                swap_d(a, i, j);
+                i++;
+                j--;
+            }
+        }
+
+        // a[lo..j] <= pivot <= a[i..hi]; lo que queda entre ambos es igual al pivote
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+}
+
+int percentiles(const double* array, int start, int end, const double* q, int n_q, double* out) {
+    int n = end - start;
+    if (array == NULL || n <= 0 || n_q <= 0 || n_q > PERCENTILE_MAX_Q) return -1;
+
+    // Orden de los percentiles de menor a mayor (n_q es chico)
+    int order[PERCENTILE_MAX_Q];
+    for (int i = 0; i < n_q; i++) {
+        if (!(q[i] >= 0.0 && q[i] <= 1.0)) return -1;
+        int j = i;
+        while (j > 0 && q[order[j - 1]] > q[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    double* a = arena_get((size_t)n);
+    if (a == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return -1;
+    }
+    memcpy(a, array + start, (size_t)n * sizeof(double));
+
+    // Tras seleccionar el rango k, todo a[k+1..] es >= a[k]: el siguiente
+    // percentil solo busca a la derecha
+    int lo = 0;
+    for (int r = 0; r < n_q; r++) {
+        double rank = q[order[r]] * (n - 1);
+        int k = (int)rank;
+        double frac = rank - k;
+
+        if (k >= lo) {
+            select_kth(a, lo, n - 1, k);
+            lo = k;
+        }
+        double v = a[k];
+
+        if (frac > 0.0 && k + 1 < n) {
+            // Vecino superior: el mínimo de la parte derecha
+            double next = a[k + 1];
+            for (int i = k + 2; i < n; i++) {
+                if (a[i] < next) next = a[i];
+            }
+            v = v * (1.0 - frac) + next * frac;
+        }
+        out[order[r]] = v;
+    }
+    return 0;
+}
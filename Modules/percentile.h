@@ -0,0 +1,38 @@
+/**
+ * @file percentile.h
+ * @brief Percentiles por selección (introselect) en tiempo lineal.
+ *
+ * Reemplaza el patrón copiar + qsort + liberar de `median()`. La copia de
+ * trabajo vive en un arena por hilo que se reutiliza entre llamadas, y varios
+ * percentiles del mismo rango salen de una sola llamada.
+ */
+
+#ifndef PERCENTILE_H
+#define PERCENTILE_H
+
+#define PERCENTILE_MAX_Q 16   // Percentiles por llamada
+
+/**
+ * @brief Calcula varios percentiles de array[start, end) sin modificar el original.
+ *
+ * Usa interpolación lineal entre rangos (rango = q * (n - 1), como numpy
+ * 'linear'); con q = 0.5 coincide exactamente con la mediana clásica (promedio
+ * de los dos centrales si n es par). Cada percentil cuesta O(n) esperado, y los
+ * siguientes solo buscan en la parte ya particionada a su derecha.
+ *
+ * @param q    Percentiles en [0, 1], en cualquier orden.
+ * @param n_q  Cantidad de percentiles (1 a PERCENTILE_MAX_Q).
+ * @param out  n_q resultados, en el mismo orden que q.
+ *
+ * @return 0 si todo fue bien, -1 si el rango está vacío, q es inválido o falla
+ *         la reserva del arena.
+ */
+int percentiles(const double* array, int start, int end, const double* q, int n_q, double* out);
+
+/**
+ * @brief Libera el arena del hilo que llama. Opcional: también se libera al
+ * terminar el hilo.
+ */
+void percentile_arena_release(void);
+
+#endif // PERCENTILE_H
@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include "../Drivers/bacn_RTI.h"
 #include "tdt.h"
+#include "../main_c/libs/trace.h"
 
 /**
  * @brief Procesa señales IQ para calcular parámetros clave de transmisión digital terrestre.
@@ -43,7 +44,7 @@
 
 extern bool program;
 
-void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, uint8_t file_sample,  char* channel) {
+static void parameter_tdt_impl(st_server *s_server, int modulation, uint64_t central_freq, uint8_t file_sample,  char* channel) {
     size_t num_samples;
     int c_f = central_freq;
 
@@ -76,7 +77,9 @@ void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, u
     Pxx = (double*) malloc(psd_size * sizeof(double));
     f = (double*) malloc(psd_size * sizeof(double));
 
+    trace_begin("load_cs8");
     complex double* IQ_data = cargar_cs8(file_sample_str, &num_samples);
+    trace_end("load_cs8");
 
     printf("Total samples: %lu\r\n", num_samples);
     delete_CS8(file_sample);
@@ -94,9 +97,14 @@ void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, u
     
     
     double mer_value = 0.0, ber_value = 0.0, c_n_value = 0.0, signal_power_value;
-
-    analyze_signal(central_freq, modulation, IQ_data, num_samples, &mer_value, &ber_value, &c_n_value, &signal_power_value);
-    welch_psd_complex(IQ_data, num_samples, 6500000, nperseg, 0, f, Pxx);
+    isdbt_result_t ofdm;
+
+    trace_begin("analyze_signal");
+    int locked = analyze_signal(central_freq, modulation, IQ_data, num_samples, &mer_value, &ber_value, &c_n_value, &signal_power_value, &ofdm);
+    trace_end("analyze_signal");
+    trace_begin("welch");
+    welch_psd_complex_ex(IQ_data, num_samples, 6500000, nperseg, 0, false, f, Pxx);
+    trace_end("welch");
     free(IQ_data);
        //real_time();
     if (nperseg % 2 != 0) {
@@ -105,29 +113,7 @@ void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, u
     }
 
 
-    // -----------Acomodar potencias de welch-----------
-    int half = nperseg / 2;
-    double* temp = (double*)malloc(nperseg * sizeof(double));
-    double* temp1 = (double*)malloc(4096 * sizeof(double));
-
-    for (int i = 0; i < half; i++) {
-        temp[i] = Pxx[half + i];
-        
-    }
-
-
-    for (int i = 0; i < half; i++) {
-        temp[half + i] = Pxx[i];
-    }
-
-
-    for (int i = 0; i < nperseg; i++) {
-        Pxx[i] = temp[i];
-    } 
-
-
-    free(temp);
-    free(temp1);
+    // Welch en orden natural de la FFT (sin fftshift): no hace falta re-acomodar
 
     // save_to_file(f, Pxx, nperseg, "data.csv");
 
@@ -210,7 +196,16 @@ void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, u
     cJSON_AddNumberToObject(json_params, "BER", ber_value);
     cJSON_AddStringToObject(json_params, "modulation", modulation_type);
     cJSON_AddStringToObject(json_params, "rate hp", "2/3");
-    cJSON_AddStringToObject(json_params, "guard", "1/8");
+    // Modo y guarda detectados por el demodulador; sin sincronismo se informa la configuración de la red
+    char guard[8];
+    snprintf(guard, sizeof(guard), "1/%d", locked ? ofdm.guard_div : 8);
+    cJSON_AddStringToObject(json_params, "guard", guard);
+    cJSON_AddBoolToObject(json_params, "lock", locked);
+    if (locked) {
+        cJSON_AddNumberToObject(json_params, "mode", ofdm.mode);
+        cJSON_AddNumberToObject(json_params, "MER p10", ofdm.mer_p10_db);
+        cJSON_AddNumberToObject(json_params, "CFO", ofdm.cfo_hz);
+    }
     cJSON_AddNumberToObject(json_params, "segment length", 1024);
     cJSON_AddNumberToObject(json_params, "fs", 20000000);
     cJSON_AddStringToObject(json_params, "window", "Hamming");
@@ -259,4 +254,10 @@ void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, u
     free(json_string);
     free(f);
     free(Pxx);
-}
\ No newline at end of file
+}
+
+void parameter_tdt(st_server *s_server, int modulation, uint64_t central_freq, uint8_t file_sample,  char* channel) {
+    trace_begin("parameter_tdt");
+    parameter_tdt_impl(s_server, modulation, central_freq, file_sample, channel);
+    trace_end("parameter_tdt");
+}
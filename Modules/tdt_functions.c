@@ -16,53 +16,40 @@
 #include "save_to_file.h"
 #include "welch.h"
 #include "tdt_functions.h"
-#include "find_closest_index.h"
 #include "parameters.h"
 
 #define M_PI 3.14159265358979323846
 #define PI 3.14159265358979323846
 
 
-double c_n(double* Pxx, double* f, int f_low, int f_high) {
-    double signal_power = median(Pxx, f_low, f_high);
-    double n = Pxx[0];
-    double c_n_ratio = 10.0 * log10(signal_power / n);
-    return c_n_ratio, signal_power;
-}
-
-
-double mer(int f_low, int f_high, double* Pxx, int N) {
-    // Inicializar los valores máximo y mínimo en el array completo
-    Pxx[513]= Pxx[510];
-    Pxx[512]= Pxx[510];
-    Pxx[511]= Pxx[510];
-    double max_power = Pxx[0];
-    double min_power = Pxx[0];
-    int a;
-
-    // Buscar la potencia máxima y mínima en todo el array Pxx
-    for (int i = 1; i < N; i++) {
-        if (Pxx[i] > max_power) {
-            max_power = Pxx[i];
-            a=i;
-        }
-        if (Pxx[i] < min_power) {
-            min_power = Pxx[i];
-            
-        }
+double c_n(double* Pxx, int N, int band_bins, int dc_bins, double* signal_power) {
+    // Dentro del canal: [dc_bins, band_bins] y su espejo en frecuencias negativas
+    int n_in = 2 * (band_bins - dc_bins + 1);
+    double* in_band = (double*)malloc(n_in * sizeof(double));
+    if (!in_band) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return NAN;
     }
-    // Calcular MER en dB como la relación entre la potencia máxima y mínima
-    return 10.0 * log10(max_power / min_power);
-}
+    for (int k = dc_bins, i = 0; k <= band_bins; k++) {
+        in_band[i++] = Pxx[k];
+        in_band[i++] = Pxx[N - k];
+    }
+    *signal_power = median(in_band, 0, n_in);
+    free(in_band);
 
+    // Fuera del canal: entre los bordes y Nyquist, contiguo en orden natural
+    double noise = median(Pxx, band_bins + 1, N - band_bins);
+    return 10.0 * log10(*signal_power / noise);
+}
 
 
-void analyze_signal(double frecuencia, int modulation, complex double* data, size_t data_len, double* mer_value, double* ber_value, double* c_n_value, double* signal_power) {
+int analyze_signal(double frecuencia, int modulation, complex double* data, size_t data_len,
+                   double* mer_value, double* ber_value, double* c_n_value, double* signal_power,
+                   isdbt_result_t* ofdm) {
     int segment_length = 4096;
     double fs = 6500000;
-    //char window[10] = 'Hamming';
-    double bandwidth = 6500000;
     double overlap = 0.0;
+    (void)frecuencia;
 
     double* f1 = (double*)malloc(segment_length * sizeof(double));
     double* Pxx1 = (double*)malloc(segment_length * sizeof(double));
@@ -72,83 +59,37 @@ void analyze_signal(double frecuencia, int modulation, complex double* data, siz
         fprintf(stderr, "Memory allocation failed.\n");
         free(f1);
         free(Pxx1);
-        return; // Usa return para manejar errores sin exit
-    }
-    // Calcular PSD usando Welch
-    welch_psd_complex(data, data_len, fs, segment_length, overlap, f1, Pxx1);
-
-    //-----------Acomodar potencias de welch-----------
-    int half = segment_length / 2;
-    double* temp = (double*)malloc(segment_length * sizeof(double));
-
-    for (int i = 0; i < half; i++) {
-        temp[i] = Pxx1[half + i];
-    }
-
-
-    for (int i = 0; i < half; i++) {
-        temp[half + i] = Pxx1[i];
-    }
-
-    for (int i = 0; i < segment_length; i++) {
-        Pxx1[i] = temp[i];
-    }
-
-    free(temp);
-
-    for (int i = 0; i < segment_length; i++) {
-        f1[i] = (f1[i] + frecuencia) / 1000000;
-    }
-    int index = segment_length/2 ;
-    int count = segment_length*0.002;
-    int b=index-(count+5);
-    int a=index;
-
-    for (int i=0; i<count; i++)
-    {   
-        b=b-3;
-        Pxx1[a]=Pxx1[b];
-        a=a-1;
-        
-        
-    }
-    a=index;
-    for (int i=0; i<count; i++)
-    {   
-        Pxx1[a]=Pxx1[b];
-        a=a+1;
-        b=b+2;
-        
+        *mer_value = NAN;
+        *ber_value = NAN;
+        *c_n_value = NAN;
+        *signal_power = NAN;
+        return 0; // Usa return para manejar errores sin exit
     }
+    // PSD por Welch en orden natural (DC en 0): da la potencia y el C/N de respaldo
+    welch_psd_complex_ex(data, data_len, fs, segment_length, overlap, false, f1, Pxx1);
 
-    
+    int band_bins = (int)(TDT_BAND_HALF_HZ / fs * segment_length);
+    int dc_bins = (int)(segment_length * 0.002) + 1;    // Spike de DC del front-end
+    *c_n_value = c_n(Pxx1, segment_length, band_bins, dc_bins, signal_power);
+    *mer_value = NAN;
+    *ber_value = NAN;
 
-    double fc = frecuencia;
-    int f_low = find_closest_index(f1, segment_length/2, fc - 3);
-    int f_high = find_closest_index(f1, segment_length/2, fc + 3);
+    free(f1);
+    free(Pxx1);
 
-    f_low = 40;
-    f_high = 950;
+    if (!ofdm) return 0;
 
-    // Verificación de índices válidos para evitar accesos fuera de los límites
-    if (f_low < 0 || f_high >= segment_length || f_low >= f_high) {
-        fprintf(stderr, "Invalid frequency indices.\n");
-        free(f1);
-        free(Pxx1);
-        return;
+    // MER, BER y C/N medidos sobre la señal demodulada
+    isdbt_cfg_t cfg = { 0, 0, modulation, 0 };
+    if (isdbt_measure(data, data_len, fs, &cfg, ofdm) != 0) {
+        fprintf(stderr, "[TDT] No ISDB-T lock (CP correlation %.2f), reporting spectral C/N only.\n",
+                ofdm->cp_corr);
+        return 0;
     }
-
-    // Calcular MER, BER y C/N
-    *mer_value = mer(f_low, f_high , Pxx1, 1024);
-
-    float MOD= modulation;
-    *ber_value = calculate_BER_from_snr(*mer_value, MOD);
-   
-    *c_n_value, *signal_power = c_n(Pxx1, f1, f_low, f_high);
-
-    // Liberar memoria
-    free(f1);
-    free(Pxx1);
+    *mer_value = ofdm->mer_db;
+    *ber_value = ofdm->ber;
+    *c_n_value = ofdm->cn_db;
+    return 1;
 }
 
 
@@ -224,27 +165,9 @@ int compare_doubles(const void* a, const void* b) {
 }
 
 
-static double integrand(double t) {
-    return exp(-t * t);
-}
-
-double erfc_manual(double x, int num_steps) {
-    if (x > 10) return 0.0;  // Limitar x para evitar inestabilidad
-
-    double step_size = 10.0 / num_steps;
-    double integral_approx = 0.0;
-
-    for (int i = 0; i < num_steps; i++) {
-        double t1 = x + i * step_size;
-        double t2 = x + (i + 1) * step_size;
-        integral_approx += 0.5 * (integrand(t1) + integrand(t2)) * step_size;
-    }
-
-    return (2.0 / sqrt(PI)) * integral_approx;
-}
-
 double Q(double x) {
-    return 0.5 * erfc_manual(x / sqrt(2.0), 10000);
+    // erfc de libm: exacta a precisión double y sin el truncamiento en x + 10
+    return 0.5 * erfc(x / sqrt(2.0));
 }
 
 
@@ -255,4 +178,32 @@ double calculate_BER_from_snr(double SNR, float M) {
     }
 
     return (4.0 / log2(M)) * (1.0 - 1.0 / sqrt(M)) * Q(sqrt((3.0 * log2(M) / (M - 1.0)) * SNR));
-}
\ No newline at end of file
+}
+
+int calculate_BER_batch(const double* SNR, const float* M, int n, double* ber_out) {
+    if (SNR == NULL || M == NULL || ber_out == NULL || n < 0) return -1;
+
+    int invalid = 0;
+    float last_M = 0.0f;
+    double coef = 0.0, gain = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        // Constantes de la modulación, recalculadas solo cuando cambia M
+        if (M[i] != last_M) {
+            last_M = M[i];
+            if (M[i] > 1) {
+                double bits = log2(M[i]);
+                coef = (4.0 / bits) * (1.0 - 1.0 / sqrt(M[i]));
+                gain = 3.0 * bits / (M[i] - 1.0) / 2.0;     // Incluye el 1/2 de Q -> erfc
+            }
+        }
+        if (!(SNR[i] > 0) || !(M[i] > 1)) {
+            ber_out[i] = NAN;
+            invalid++;
+            continue;
+        }
+        // coef * Q(sqrt(k * SNR)) = coef/2 * erfc(sqrt(k * SNR / 2))
+        ber_out[i] = 0.5 * coef * erfc(sqrt(gain * SNR[i]));
+    }
+    return invalid;
+}
@@ -16,46 +16,51 @@
 #include <math.h>
 #include <complex.h>
 
-#define M_PI 3.14159265358979323846
+#include "isdbt.h"
 
-/**
- * @brief Calcula la relación portadora/ruido (C/N) y la potencia de señal.
- *
- * @param Pxx Densidad espectral de potencia (PSD) calculada.
- * @param f Vector de frecuencias asociadas a la PSD.
- * @param f_low Índice inferior del rango de frecuencia de interés.
- * @param f_high Índice superior del rango de frecuencia de interés.
- * @return Relación C/N (en dB) y potencia de señal.
- */
+#define M_PI 3.14159265358979323846
 
-double c_n(double* Pxx, double* f, int f_low, int f_high);
+#define TDT_BAND_HALF_HZ 2.79e6     // Mitad del ancho ocupado por ISDB-T en un canal de 6 MHz
 
 /**
- * @brief Calcula la Modulation Error Ratio (MER).
+ * @brief C/N espectral, el respaldo cuando no hay sincronismo OFDM.
+ *
+ * Compara la mediana de la PSD dentro del canal con la de los bins entre el
+ * borde del canal y Nyquist.
  *
- * @param f_low Índice inferior del rango de frecuencia de interés.
- * @param f_high Índice superior del rango de frecuencia de interés.
- * @param Pxx Densidad espectral de potencia (PSD) calculada.
- * @param N Longitud del vector PSD.
- * @return Valor de MER en dB.
+ * @param Pxx PSD en orden natural de la FFT (DC en el índice 0).
+ * @param N Longitud de la PSD.
+ * @param band_bins Bins ocupados por el canal a cada lado de DC.
+ * @param dc_bins Bins alrededor de DC que se excluyen (spike del front-end).
+ * @param signal_power Mediana de la PSD dentro del canal.
+ * @return Relación C/N en dB.
  */
 
-double mer(int f_low, int f_high, double* Pxx, int N);
+double c_n(double* Pxx, int N, int band_bins, int dc_bins, double* signal_power);
 
 /**
  * @brief Analiza señales IQ para calcular parámetros como MER, BER y C/N.
  *
+ * La potencia sale siempre de la PSD. Con `ofdm` no NULL se demodula la señal
+ * ISDB-T (ver isdbt.h) y MER, BER y C/N son los medidos sobre las
+ * constelaciones; si no hay sincronismo, MER y BER quedan en NAN y el C/N es
+ * el espectral. Si falta memoria todas las salidas quedan en NAN.
+ *
  * @param frecuencia Frecuencia central de la señal (en Hz).
- * @param modulation Tipo de modulación (ej., 64-QAM, 16-QAM).
- * @param data Datos IQ complejos.
+ * @param modulation Modulación de las portadoras de datos (4, 16 o 64).
+ * @param data Datos IQ complejos, a 6.5 MS/s.
  * @param data_len Número de muestras en los datos IQ.
  * @param mer_value Referencia para almacenar el valor calculado de MER.
  * @param ber_value Referencia para almacenar el valor calculado de BER.
  * @param c_n_value Referencia para almacenar el valor calculado de C/N.
  * @param signal_power Referencia para almacenar la potencia de la señal.
+ * @param ofdm Resultado completo del demodulador, o NULL para medir solo la potencia.
+ * @return 1 si hubo sincronismo ISDB-T, 0 si no.
  */
 
-void analyze_signal(double frecuencia, int modulation, complex double* data, size_t data_len, double* mer_value, double* ber_value, double* c_n_value, double* signal_power);
+int analyze_signal(double frecuencia, int modulation, complex double* data, size_t data_len,
+                   double* mer_value, double* ber_value, double* c_n_value, double* signal_power,
+                   isdbt_result_t* ofdm);
 
 /**
  * @brief Realiza un desplazamiento FFT para reordenar el espectro.
@@ -122,25 +127,6 @@ double median(double* array, int start, int end);
 
 int compare_doubles(const void* a, const void* b);
 
-/**
- * @brief Función base para la función de error complementaria.
- *
- * @param t Valor de entrada.
- * @return Resultado de la función integrando `exp(-t^2)`.
- */
-
-static double integrand(double t);
-
-/**
- * @brief Calcula la función de error complementaria (erfc) manualmente.
- *
- * @param x Valor de entrada.
- * @param num_steps Número de pasos en la aproximación.
- * @return Valor aproximado de `erfc(x)`.
- */
-
-double erfc_manual(double x, int num_steps);
-
 /**
  * @brief Calcula la función Q para un valor dado.
  *
@@ -160,6 +146,20 @@ double Q(double x);
 
 double calculate_BER_from_snr(double SNR, float M);
 
+/**
+ * @brief Calcula la BER de un arreglo de pares (SNR, M) en una sola llamada.
+ *
+ * Misma fórmula que `calculate_BER_from_snr`, con `erfc` de libm; las
+ * constantes de la modulación se reutilizan mientras M no cambie, así que
+ * curvas de BER o la BER por portadora cuestan un `erfc` por punto.
+ *
+ * @param SNR     n valores de relación señal-ruido.
+ * @param M       n órdenes de modulación.
+ * @param ber_out n resultados; NAN donde SNR <= 0 o M <= 1.
+ * @return Número de entradas inválidas, o -1 si algún puntero es NULL.
+ */
+int calculate_BER_batch(const double* SNR, const float* M, int n, double* ber_out);
+
 #endif // ANALYZE_SIGNAL_H
 
 
@@ -14,6 +14,8 @@
 #include <complex.h>  // Para el tipo double complex
 #include <stdbool.h>
 
+#include "freq_grid.h"
+
 #define PI 3.14159265358979323846
 
 /**
@@ -62,11 +64,23 @@ void welch_psd_complex(complex double* signal, size_t N_signal, double fs,
                        int segment_length, double overlap, double* f_out, double* P_welch_out);
 
 
+/**
+ * @brief Igual que `welch_psd_complex`, pero permite omitir el fftshift.
+ *
+ * Con `shift = false` la PSD queda en orden natural de la FFT (DC en el índice 0),
+ * lo que evita re-acomodar el vector a mano en los llamadores.
+ */
+void welch_psd_complex_ex(complex double* signal, size_t N_signal, double fs,
+                          int segment_length, double overlap, bool shift,
+                          double* f_out, double* P_welch_out);
 
 /**
  * @brief Ejecuta una correcion del pico dc spile cambiando los vectores centrales 
  * de la muestra procesada, con otra muestra tomada 10MHz mas arriba
+ *
+ * @param g1 Rejilla de frecuencias de psd1 (define su longitud).
+ * @param g2 Rejilla de frecuencias de psd2 (define su longitud).
  */
-bool DC_spike_correction(double* psd1, double* f1, double* psd2, double* f2);
+bool DC_spike_correction(double* psd1, const freq_grid_t* g1, double* psd2, const freq_grid_t* g2);
 
 #endif // WELCH_H
@@ -0,0 +1,609 @@
+/**
+ * @file bench/bench_dsp.c
+ * @brief DSP micro-benchmarks with machine-readable (JSON) output
+ *
+ * Drives the PSD paths of both stacks with synthetic IQ:
+ *   - main_c/libs/psd.c: load_iq_from_buffer, execute_welch_psd,
+ *     execute_welch_psd_plan (overlap / window / precision / threads), scale_psd
+ *   - Modules: welch_psd_complex, cargar_cs8 and the per-channel metrics
+ *     used by parameter() (freq_grid channel table + chan_metrics_compute)
+ *
+ * Every case reports throughput (MS/s), ns per output bin, heap allocations
+ * per call and the process peak RSS, so runs on the Pi and on x86 hosts can
+ * be compared with jq or a spreadsheet.
+ *
+ * Usage: bench_dsp [--quick] [--max-nperseg N] [--min-time-ms T]
+ *                  [--only NAME] [--out FILE]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+
+#include "psd.h"
+#include "../Modules/welch.h"
+#include "../Modules/cs8_to_iq.h"
+#include "../Modules/freq_grid.h"
+#include "../Modules/channel_metrics.h"
+
+#define BENCH_FS            20e6
+#define BENCH_MIN_SAMPLES   (1 << 20)
+#define BENCH_MIN_ITERS     3
+
+// =========================================================
+// ALLOCATION COUNTING
+// =========================================================
+// The glibc entry points are interposed so FFTW's allocations are counted too.
+
+static _Atomic uint64_t alloc_count = 0;
+static _Atomic uint64_t alloc_bytes = 0;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+
+static inline void count_alloc(size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_bytes, size, memory_order_relaxed);
+}
+
+void *malloc(size_t size) { count_alloc(size); return __libc_malloc(size); }
+void *calloc(size_t n, size_t size) { count_alloc(n * size); return __libc_calloc(n, size); }
+void *realloc(void *p, size_t size) { count_alloc(size); return __libc_realloc(p, size); }
+void *aligned_alloc(size_t align, size_t size) { count_alloc(size); return __libc_memalign(align, size); }
+void *memalign(size_t align, size_t size) { count_alloc(size); return __libc_memalign(align, size); }
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    count_alloc(size);
+    void *p = __libc_memalign(align, size);
+    if (!p) return 12;  // ENOMEM
+    *out = p;
+    return 0;
+}
+#define ALLOC_TRACKING 1
+#else
+#define ALLOC_TRACKING 0
+#endif
+
+// =========================================================
+// HARNESS
+// =========================================================
+
+typedef struct {
+    int quick;
+    int max_nperseg;
+    double min_time_ms;
+    const char *only;
+    FILE *out;
+    int first_result;
+} BenchOpts_t;
+
+typedef struct {
+    const char *bench;
+    const char *variant;        // Free-form parameter label, may be NULL
+    int nperseg;
+    double overlap;
+    const char *window;
+    const char *precision;
+    int threads;
+    size_t samples_per_call;    // Input samples consumed by one call
+    size_t bins_per_call;       // Output bins produced by one call
+} BenchCase_t;
+
+typedef void (*bench_fn)(void *ctx);
+
+static BenchOpts_t opts = { 0, 1 << 20, 200.0, NULL, NULL, 1 };
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static int selected(const char *bench) {
+    return !opts.only || strcmp(opts.only, bench) == 0;
+}
+
+static void emit(const BenchCase_t *c, long iters, double elapsed_ms,
+                 uint64_t allocs, uint64_t bytes) {
+    double ns_call = elapsed_ms * 1e6 / iters;
+    double msps = c->samples_per_call ? (double)c->samples_per_call * iters / (elapsed_ms * 1e3) : 0.0;
+    double ns_bin = c->bins_per_call ? ns_call / (double)c->bins_per_call : 0.0;
+
+    fprintf(opts.out, "%s\n    {\"bench\":\"%s\"", opts.first_result ? "" : ",", c->bench);
+    opts.first_result = 0;
+    if (c->variant) fprintf(opts.out, ",\"variant\":\"%s\"", c->variant);
+    if (c->nperseg) fprintf(opts.out, ",\"nperseg\":%d", c->nperseg);
+    if (c->window) fprintf(opts.out, ",\"overlap\":%.2f,\"window\":\"%s\"", c->overlap, c->window);
+    if (c->precision) fprintf(opts.out, ",\"precision\":\"%s\"", c->precision);
+    fprintf(opts.out, ",\"threads\":%d,\"iterations\":%ld,\"ns_per_call\":%.0f",
+            c->threads ? c->threads : 1, iters, ns_call);
+    fprintf(opts.out, ",\"msps\":%.3f,\"ns_per_bin\":%.3f", msps, ns_bin);
+    if (ALLOC_TRACKING) {
+        fprintf(opts.out, ",\"allocs_per_call\":%.2f,\"alloc_bytes_per_call\":%.0f",
+                (double)allocs / iters, (double)bytes / iters);
+    }
+    fprintf(opts.out, ",\"peak_rss_kb\":%ld}", peak_rss_kb());
+    fflush(opts.out);
+
+    fprintf(stderr, "  %-22s %-10s n=%-8d thr=%d  %10.3f MS/s  %9.2f ns/bin\n",
+            c->bench, c->variant ? c->variant : (c->window ? c->window : ""),
+            c->nperseg, c->threads ? c->threads : 1, msps, ns_bin);
+}
+
+/**
+ * Runs fn once as warm-up (plans, caches), then until min_time_ms has
+ * elapsed and at least BENCH_MIN_ITERS calls were made.
+ */
+static void run_case(const BenchCase_t *c, bench_fn fn, void *ctx) {
+    fn(ctx);
+
+    uint64_t a0 = atomic_load(&alloc_count);
+    uint64_t b0 = atomic_load(&alloc_bytes);
+    long iters = 0;
+    double t0 = now_ms();
+    double elapsed;
+    do {
+        fn(ctx);
+        iters++;
+        elapsed = now_ms() - t0;
+    } while (elapsed < opts.min_time_ms || iters < BENCH_MIN_ITERS);
+
+    emit(c, iters, elapsed, atomic_load(&alloc_count) - a0, atomic_load(&alloc_bytes) - b0);
+}
+
+// =========================================================
+// SYNTHETIC INPUT
+// =========================================================
+
+// Three tones over uniform noise, quantised like the HackRF's CS8 stream
+static int8_t *make_cs8(size_t n_samples) {
+    int8_t *buf = malloc(2 * n_samples);
+    if (!buf) return NULL;
+    uint32_t rng = 0x12345678u;
+    const double f[3] = { 0.013, -0.21, 0.377 };
+    const double a[3] = { 40.0, 12.0, 4.0 };
+    for (size_t i = 0; i < n_samples; i++) {
+        double re = 0.0, im = 0.0;
+        for (int k = 0; k < 3; k++) {
+            double ph = 2.0 * M_PI * f[k] * (double)i;
+            re += a[k] * cos(ph);
+            im += a[k] * sin(ph);
+        }
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        re += (double)((int)(rng & 0xff) - 128) / 16.0;
+        im += (double)((int)((rng >> 8) & 0xff) - 128) / 16.0;
+        buf[2 * i] = (int8_t)lrint(fmax(-127.0, fmin(127.0, re)));
+        buf[2 * i + 1] = (int8_t)lrint(fmax(-127.0, fmin(127.0, im)));
+    }
+    return buf;
+}
+
+static size_t samples_for(int nperseg) {
+    size_t n = (size_t)nperseg * 4;
+    return n < BENCH_MIN_SAMPLES ? BENCH_MIN_SAMPLES : n;
+}
+
+static const char *window_name(PsdWindowType_t w) {
+    switch (w) {
+        case HAMMING_TYPE:     return "hamming";
+        case HANN_TYPE:        return "hann";
+        case RECTANGULAR_TYPE: return "rectangular";
+        case BLACKMAN_TYPE:    return "blackman";
+        case FLAT_TOP_TYPE:    return "flattop";
+        case KAISER_TYPE:      return "kaiser";
+        case TUKEY_TYPE:       return "tukey";
+        default:               return "?";
+    }
+}
+
+// =========================================================
+// CASES
+// =========================================================
+
+typedef struct {
+    const int8_t *cs8;
+    size_t n_samples;
+} LoadCtx_t;
+
+static void do_load_iq(void *p) {
+    LoadCtx_t *c = p;
+    free_signal_iq(load_iq_from_buffer(c->cs8, 2 * c->n_samples));
+}
+
+typedef struct {
+    const char *path;
+} CargarCtx_t;
+
+static void do_cargar_cs8(void *p) {
+    size_t n = 0;
+    free(cargar_cs8(((CargarCtx_t*)p)->path, &n));
+}
+
+typedef struct {
+    signal_iq_t *sig;
+    PsdConfig_t cfg;
+    const PsdPlan_t *plan;
+    PsdUnit_t unit;
+    double *f;
+    double *p;
+} WelchCtx_t;
+
+static void do_execute_welch(void *p) {
+    WelchCtx_t *c = p;
+    execute_welch_psd(c->sig, &c->cfg, c->f, c->p);
+}
+
+static void do_welch_plan(void *p) {
+    WelchCtx_t *c = p;
+    execute_welch_psd_plan(c->sig, c->plan, c->unit, NULL, NULL, c->p);
+}
+
+typedef struct {
+    WelchCtx_t base;
+    int threads;
+    int iters_per_thread;
+} ThreadCtx_t;
+
+static void *welch_thread_main(void *p) {
+    ThreadCtx_t *t = p;
+    double *out = malloc((size_t)t->base.cfg.nperseg * sizeof(double));
+    if (!out) return NULL;
+    for (int i = 0; i < t->iters_per_thread; i++) {
+        execute_welch_psd_plan(t->base.sig, t->base.plan, t->base.unit, NULL, NULL, out);
+    }
+    free(out);
+    return NULL;
+}
+
+// One "call" = every thread running iters_per_thread plans concurrently
+static void do_welch_threads(void *p) {
+    ThreadCtx_t *t = p;
+    pthread_t tid[256];
+    for (int i = 0; i < t->threads; i++) pthread_create(&tid[i], NULL, welch_thread_main, t);
+    for (int i = 0; i < t->threads; i++) pthread_join(tid[i], NULL);
+}
+
+typedef struct {
+    complex double *x;
+    size_t n;
+    int nperseg;
+    double overlap;
+    double *f;
+    double *p;
+} ModWelchCtx_t;
+
+static void do_welch_complex(void *p) {
+    ModWelchCtx_t *c = p;
+    welch_psd_complex(c->x, c->n, BENCH_FS, c->nperseg, c->overlap, c->f, c->p);
+}
+
+typedef struct {
+    double *src;
+    double *work;
+    int n;
+} ScaleCtx_t;
+
+static void do_scale_psd(void *p) {
+    ScaleCtx_t *c = p;
+    memcpy(c->work, c->src, (size_t)c->n * sizeof(double));
+    scale_psd(c->work, c->n, "dBm");
+}
+
+typedef struct {
+    double *pxx;
+    double *f;
+    int n;
+    const double *centers;
+    const double *bws;
+    int channels;
+    freq_range_t *ranges;
+    chan_metrics_t *metrics;
+    double sink;
+} ChannelCtx_t;
+
+// The per-channel stage of parameter() without the JSON output
+static void do_channel_metrics(void *p) {
+    ChannelCtx_t *c = p;
+    freq_grid_t grid = freq_grid_from_array(c->f, c->n);
+    freq_grid_channel_table(&grid, c->centers, c->bws, c->channels, c->ranges);
+    const cfar_cfg_t cfar = CFAR_CFG_DEFAULT;
+    if (chan_metrics_compute(c->pxx, NULL, &grid, c->ranges, c->channels, -60.0, &cfar, c->metrics) != 0) return;
+    for (int idx = 0; idx < c->channels; idx++) {
+        c->sink += c->metrics->snr_db[idx] + c->metrics->median[idx];
+    }
+}
+
+// =========================================================
+// SWEEPS
+// =========================================================
+
+static int nperseg_list(int *out) {
+    int n = 0;
+    for (int s = 1024; s <= opts.max_nperseg; s *= opts.quick ? 16 : 4) out[n++] = s;
+    return n;
+}
+
+static void bench_load(void) {
+    size_t n = opts.quick ? (1u << 20) : (1u << 22);
+    int8_t *cs8 = make_cs8(n);
+    if (!cs8) return;
+
+    if (selected("load_iq_from_buffer")) {
+        LoadCtx_t ctx = { cs8, n };
+        BenchCase_t c = { .bench = "load_iq_from_buffer", .samples_per_call = n, .bins_per_call = n };
+        run_case(&c, do_load_iq, &ctx);
+    }
+
+    if (selected("cargar_cs8")) {
+        char path[] = "/tmp/bench_dsp_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd >= 0) {
+            FILE *fp = fdopen(fd, "wb");
+            fwrite(cs8, 1, 2 * n, fp);
+            fclose(fp);
+            CargarCtx_t ctx = { path };
+            BenchCase_t c = { .bench = "cargar_cs8", .variant = "page_cache",
+                              .samples_per_call = n, .bins_per_call = n };
+            run_case(&c, do_cargar_cs8, &ctx);
+            unlink(path);
+        }
+    }
+    free(cs8);
+}
+
+static signal_iq_t *make_signal(size_t n) {
+    int8_t *cs8 = make_cs8(n);
+    if (!cs8) return NULL;
+    signal_iq_t *sig = load_iq_from_buffer(cs8, 2 * n);
+    free(cs8);
+    return sig;
+}
+
+static PsdConfig_t make_cfg(int nperseg, double overlap, PsdWindowType_t w, bool exact_log) {
+    PsdConfig_t cfg = {0};
+    cfg.window_type = w;
+    cfg.sample_rate = BENCH_FS;
+    cfg.nperseg = nperseg;
+    cfg.noverlap = (int)(nperseg * overlap);
+    cfg.decimation = 1;
+    cfg.exact_log = exact_log;
+    return cfg;
+}
+
+static void run_plan_case(signal_iq_t *sig, size_t n, int nperseg, double overlap,
+                          PsdWindowType_t w, bool exact_log, const char *bench) {
+    PsdConfig_t cfg = make_cfg(nperseg, overlap, w, exact_log);
+    PsdPlan_t *plan = psd_plan_get(&cfg);
+    double *p = malloc((size_t)nperseg * sizeof(double));
+    if (plan && p) {
+        WelchCtx_t ctx = { sig, cfg, plan, PSD_UNIT_DBM, NULL, p };
+        BenchCase_t c = { .bench = bench, .nperseg = nperseg, .overlap = overlap,
+                          .window = window_name(w),
+                          .precision = exact_log ? "exact_log" : "fast_log",
+                          .samples_per_call = n, .bins_per_call = (size_t)nperseg };
+        run_case(&c, do_welch_plan, &ctx);
+    }
+    free(p);
+    psd_plan_release(plan);
+}
+
+static void bench_psd(void) {
+    int sizes[16];
+    int n_sizes = nperseg_list(sizes);
+
+    for (int i = 0; i < n_sizes; i++) {
+        int nperseg = sizes[i];
+        size_t n = samples_for(nperseg);
+        signal_iq_t *sig = make_signal(n);
+        double *f = malloc((size_t)nperseg * sizeof(double));
+        double *p = malloc((size_t)nperseg * sizeof(double));
+        if (!sig || !f || !p) {
+            free_signal_iq(sig); free(f); free(p);
+            continue;
+        }
+
+        if (selected("execute_welch_psd")) {
+            WelchCtx_t ctx = { sig, make_cfg(nperseg, 0.5, HANN_TYPE, false), NULL, PSD_UNIT_DENSITY, f, p };
+            BenchCase_t c = { .bench = "execute_welch_psd", .nperseg = nperseg, .overlap = 0.5,
+                              .window = "hann", .samples_per_call = n, .bins_per_call = (size_t)nperseg };
+            run_case(&c, do_execute_welch, &ctx);
+        }
+        if (selected("welch_plan")) {
+            run_plan_case(sig, n, nperseg, 0.5, HANN_TYPE, false, "welch_plan");
+        }
+        if (selected("scale_psd")) {
+            execute_welch_psd(sig, &(PsdConfig_t){ .window_type = HANN_TYPE, .sample_rate = BENCH_FS,
+                                                   .nperseg = nperseg, .noverlap = nperseg / 2,
+                                                   .decimation = 1 }, f, p);
+            double *work = malloc((size_t)nperseg * sizeof(double));
+            if (work) {
+                ScaleCtx_t ctx = { p, work, nperseg };
+                BenchCase_t c = { .bench = "scale_psd", .variant = "dBm", .nperseg = nperseg,
+                                  .samples_per_call = 0, .bins_per_call = (size_t)nperseg };
+                run_case(&c, do_scale_psd, &ctx);
+                free(work);
+            }
+        }
+        if (selected("welch_psd_complex")) {
+            const double overlaps[2] = { 0.0, 0.5 };
+            for (int k = 0; k < 2; k++) {
+                ModWelchCtx_t ctx = { sig->signal_iq, n, nperseg, overlaps[k], f, p };
+                BenchCase_t c = { .bench = "welch_psd_complex", .nperseg = nperseg,
+                                  .overlap = overlaps[k], .window = "hamming",
+                                  .samples_per_call = n, .bins_per_call = (size_t)nperseg };
+                run_case(&c, do_welch_complex, &ctx);
+            }
+        }
+
+        free_signal_iq(sig);
+        free(f);
+        free(p);
+    }
+}
+
+static void bench_plan_axes(void) {
+    const int nperseg = 16384;
+    size_t n = samples_for(nperseg);
+    signal_iq_t *sig = make_signal(n);
+    if (!sig) return;
+
+    if (selected("welch_plan_overlap")) {
+        const double overlaps[4] = { 0.0, 0.25, 0.5, 0.75 };
+        for (int k = 0; k < 4; k++) {
+            run_plan_case(sig, n, nperseg, overlaps[k], HANN_TYPE, false, "welch_plan_overlap");
+        }
+    }
+    if (selected("welch_plan_window")) {
+        for (int w = HAMMING_TYPE; w <= TUKEY_TYPE; w++) {
+            run_plan_case(sig, n, nperseg, 0.5, (PsdWindowType_t)w, false, "welch_plan_window");
+        }
+    }
+    if (selected("welch_plan_precision")) {
+        run_plan_case(sig, n, nperseg, 0.5, HANN_TYPE, false, "welch_plan_precision");
+        run_plan_case(sig, n, nperseg, 0.5, HANN_TYPE, true, "welch_plan_precision");
+    }
+
+    if (selected("welch_plan_threads")) {
+        PsdConfig_t cfg = make_cfg(nperseg, 0.5, HANN_TYPE, false);
+        PsdPlan_t *plan = psd_plan_get(&cfg);
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        if (ncpu < 1) ncpu = 1;
+        if (ncpu > 256) ncpu = 256;
+
+        // Powers of two below ncpu, then ncpu itself (1, 2, 4, 6 on a 6-core host)
+        int steps[16], n_steps = 0;
+        for (int t = 1; t < ncpu; t *= 2) steps[n_steps++] = t;
+        steps[n_steps++] = (int)ncpu;
+
+        for (int i = 0; plan && i < n_steps; i++) {
+            int threads = steps[i];
+            ThreadCtx_t ctx = { { sig, cfg, plan, PSD_UNIT_DBM, NULL, NULL }, threads, 4 };
+            BenchCase_t c = { .bench = "welch_plan_threads", .nperseg = nperseg, .overlap = 0.5,
+                              .window = "hann", .precision = "fast_log", .threads = threads,
+                              .samples_per_call = n * (size_t)threads * 4,
+                              .bins_per_call = (size_t)nperseg * threads * 4 };
+            run_case(&c, do_welch_threads, &ctx);
+        }
+        psd_plan_release(plan);
+    }
+    free_signal_iq(sig);
+}
+
+static void bench_channels(void) {
+    if (!selected("channel_metrics")) return;
+
+    // Same shape as parameter(): 32768-bin PSD over 20 MHz, FM-like raster
+    const int n = 32768;
+    size_t n_samples = samples_for(n);
+    signal_iq_t *sig = make_signal(n_samples);
+    double *f = malloc(n * sizeof(double));
+    double *pxx = malloc(n * sizeof(double));
+    enum { CHANNELS = 64 };
+    double centers[CHANNELS], bws[CHANNELS];
+    freq_range_t ranges[CHANNELS];
+    if (sig && f && pxx) {
+        welch_psd_complex_ex(sig->signal_iq, n_samples, BENCH_FS, n, 0, false, f, pxx);
+        for (int i = 0; i < n; i++) f[i] = (f[i] + 98e6) / 1e6;
+        for (int k = 0; k < CHANNELS; k++) {
+            centers[k] = 88.2 + k * 0.3;
+            bws[k] = 0.2;
+        }
+        chan_metrics_t metrics;
+        if (chan_metrics_alloc(&metrics, CHANNELS) == 0) {
+            ChannelCtx_t ctx = { pxx, f, n, centers, bws, CHANNELS, ranges, &metrics, 0.0 };
+            BenchCase_t c = { .bench = "channel_metrics", .variant = "64ch", .nperseg = n,
+                              .samples_per_call = 0, .bins_per_call = (size_t)n };
+            run_case(&c, do_channel_metrics, &ctx);
+            chan_metrics_free(&metrics);
+        }
+    }
+    free_signal_iq(sig);
+    free(f);
+    free(pxx);
+}
+
+// =========================================================
+// MAIN
+// =========================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Usage: %s [--quick] [--max-nperseg N] [--min-time-ms T] [--only NAME] [--out FILE]\n"
+            "  NAME: load_iq_from_buffer cargar_cs8 execute_welch_psd welch_plan scale_psd\n"
+            "        welch_psd_complex welch_plan_overlap welch_plan_window\n"
+            "        welch_plan_precision welch_plan_threads channel_metrics\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            opts.quick = 1;
+            opts.max_nperseg = 65536;
+            opts.min_time_ms = 50.0;
+        } else if (strcmp(argv[i], "--max-nperseg") == 0 && i + 1 < argc) {
+            opts.max_nperseg = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+            opts.min_time_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            opts.only = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (out_path) {
+        opts.out = fopen(out_path, "w");
+    } else {
+        // JSON keeps the real stdout; library printf chatter goes to stderr
+        int fd = dup(STDOUT_FILENO);
+        opts.out = (fd >= 0) ? fdopen(fd, "w") : NULL;
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    if (!opts.out) {
+        fprintf(stderr, "[BENCH] Cannot open %s\n", out_path);
+        return 1;
+    }
+
+    struct utsname un;
+    uname(&un);
+    char host[64] = "";
+    gethostname(host, sizeof(host) - 1);
+    fprintf(opts.out, "{\n  \"host\":{\"name\":\"%s\",\"machine\":\"%s\",\"kernel\":\"%s\",\"cpus\":%ld},\n",
+            host, un.machine, un.release, sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(opts.out, "  \"config\":{\"fs\":%.0f,\"min_time_ms\":%.0f,\"max_nperseg\":%d,\"alloc_tracking\":%s},\n",
+            BENCH_FS, opts.min_time_ms, opts.max_nperseg, ALLOC_TRACKING ? "true" : "false");
+    fprintf(opts.out, "  \"results\":[");
+
+    bench_load();
+    bench_psd();
+    bench_plan_axes();
+    bench_channels();
+
+    fprintf(opts.out, "\n  ]\n}\n");
+    fclose(opts.out);
+    return 0;
+}
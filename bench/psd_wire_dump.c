@@ -0,0 +1,143 @@
+/**
+ * @file bench/psd_wire_dump.c
+ * @brief Writes binary PSD wire frames plus the traces they encode, for the
+ * C -> Python round-trip check (utils/psd_wire_check.py)
+ *
+ * Each frame goes to stdout as little-endian
+ *   u32 header length, header, u32 payload length, payload,
+ *   u32 bins, f64 reference[bins]
+ * and covers F32, Q16 and Q8 with delta frames, two interleaved configs
+ * sharing the encoder table, saturated bins and linear units.
+ *
+ * Usage: psd_wire_dump [BINS] > frames.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "psd_wire.h"
+
+#define DUMP_DEFAULT_BINS   4096
+#define DUMP_FRAMES         40
+
+static uint32_t rng_state = 0x9E3779B9u;
+
+static double rng_uniform(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (double)rng_state / 4294967296.0;
+}
+
+// Noise floor around -100 dBm with two carriers that drift a little per frame
+static void make_trace(double *psd, size_t n, int frame, double offset_db) {
+    for (size_t i = 0; i < n; i++) {
+        double x = (double)i / (double)n;
+        double v = -100.0 + offset_db + 3.0 * (rng_uniform() - 0.5);
+        v += 45.0 * exp(-pow((x - 0.3 - 0.001 * frame) / 0.01, 2.0));
+        v += 25.0 * exp(-pow((x - 0.7) / 0.03, 2.0));
+        psd[i] = v;
+    }
+}
+
+static void put_u32(uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    fwrite(b, 1, 4, stdout);
+}
+
+static int emit(PsdWireEncoder_t *enc, const DesiredCfg_t *cfg, PsdUnit_t unit,
+                const double *psd, size_t n) {
+    PsdWireHeader_t hdr = {
+        .start_hz = (double)cfg->center_freq - cfg->sample_rate / 2.0,
+        .step_hz = cfg->sample_rate / (double)n,
+        .bins = (uint32_t)n,
+        .units = (uint8_t)unit,
+        .timestamp_ns = 1700000000000000000ULL,
+        .config_hash = psd_config_hash(cfg),
+        .request_id = cfg->request_id,
+    };
+
+    size_t payload_len = 0;
+    const uint8_t *payload = psd_wire_encode(enc, &hdr, psd, n, &payload_len);
+    if (!payload) return -1;
+
+    uint8_t header[PSD_WIRE_HEADER_MAX];
+    size_t header_len = psd_wire_pack_header(&hdr, header);
+
+    put_u32((uint32_t)header_len);
+    fwrite(header, 1, header_len, stdout);
+    put_u32((uint32_t)payload_len);
+    fwrite(payload, 1, payload_len, stdout);
+    put_u32((uint32_t)n);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t bits;
+        memcpy(&bits, &psd[i], sizeof(bits));
+        put_u32((uint32_t)bits);
+        put_u32((uint32_t)(bits >> 32));
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t n = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : DUMP_DEFAULT_BINS;
+    if (n < 16) {
+        fprintf(stderr, "[WIRE] BINS must be at least 16\n");
+        return 1;
+    }
+
+    double *psd = malloc(n * sizeof(double));
+    if (!psd) return 1;
+
+    DesiredCfg_t cfg_a = { .center_freq = 98000000, .sample_rate = 20e6, .rbw = 10000,
+                           .scale = "dBm", .request_id = "wire-a" };
+    DesiredCfg_t cfg_b = cfg_a;
+    cfg_b.center_freq = 600000000;
+    cfg_b.request_id = NULL;
+
+    PsdWireEncoderTable_t table = {0};
+    int rc = 0;
+
+    // 1) Every encoding on one config, long enough to cross a keyframe interval
+    const PsdWireEncoding_t encodings[] = { PSD_WIRE_F32, PSD_WIRE_Q16, PSD_WIRE_Q8 };
+    for (int e = 0; e < 3 && rc == 0; e++) {
+        for (int f = 0; f < DUMP_FRAMES && rc == 0; f++) {
+            PsdWireEncoder_t *enc = psd_wire_encoder_lookup(&table, psd_config_hash(&cfg_a));
+            psd_wire_encoder_config(enc, encodings[e], 0.0, 0);
+            make_trace(psd, n, f, 0.0);
+            rc = emit(enc, &cfg_a, PSD_UNIT_DBM, psd, n);
+        }
+    }
+
+    // 2) Two configs interleaved frame by frame: each keeps its own reference
+    for (int f = 0; f < DUMP_FRAMES && rc == 0; f++) {
+        const DesiredCfg_t *cfg = (f & 1) ? &cfg_b : &cfg_a;
+        PsdWireEncoder_t *enc = psd_wire_encoder_lookup(&table, psd_config_hash(cfg));
+        psd_wire_encoder_config(enc, PSD_WIRE_Q16, 0.0, 0);
+        make_trace(psd, n, f, (f & 1) ? 20.0 : 0.0);
+        rc = emit(enc, cfg, PSD_UNIT_DBM, psd, n);
+    }
+
+    // 3) Saturated bins (NaN and out of range) and linear units
+    if (rc == 0) {
+        PsdWireEncoder_t *enc = psd_wire_encoder_lookup(&table, psd_config_hash(&cfg_a));
+        psd_wire_encoder_config(enc, PSD_WIRE_Q8, 0.0, 0);
+        make_trace(psd, n, 0, 0.0);
+        psd[0] = NAN;
+        psd[1] = 1e9;
+        rc = emit(enc, &cfg_a, PSD_UNIT_DBM, psd, n);
+    }
+    if (rc == 0) {
+        PsdWireEncoder_t *enc = psd_wire_encoder_lookup(&table, psd_config_hash(&cfg_b));
+        psd_wire_encoder_config(enc, PSD_WIRE_Q16, 0.0, 0);
+        for (size_t i = 0; i < n; i++) psd[i] = 1e-12 * (1.0 + rng_uniform());
+        rc = emit(enc, &cfg_b, PSD_UNIT_WATTS, psd, n);
+    }
+
+    psd_wire_encoder_table_free(&table);
+    free(psd);
+    if (rc != 0) fprintf(stderr, "[WIRE] Encoding failed\n");
+    return rc == 0 ? 0 : 1;
+}
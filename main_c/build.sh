@@ -16,7 +16,7 @@ LIB_SRCS=$(ls libs/*.c)
 OUT="rf_metrics"
 
 # Librerías a enlazar
-LIBS="-lhackrf -lzmq -lcjson -lfftw3 -lm "
+LIBS="-lhackrf -lzmq -lcjson -lfftw3 -lm -lrt "
 
 echo "Compilando motor C..."
 echo "  Fuentes: $MAIN_SRC $LIB_SRCS"
@@ -0,0 +1,94 @@
+/**
+ * @file Drivers/cmd_queue.c
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cmd_queue.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+
+int cq_init(cmd_queue_t *q, size_t initial_cap) {
+    if (initial_cap == 0) initial_cap = 16;
+    q->items = malloc(initial_cap * sizeof(void*));
+    if (!q->items) return -1;
+    q->cap = initial_cap;
+    q->head = 0;
+    q->count = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    return 0;
+}
+
+void cq_free(cmd_queue_t *q) {
+    free(q->items);
+    q->items = NULL;
+    q->cap = q->count = q->head = 0;
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+}
+
+int cq_push(cmd_queue_t *q, void *item) {
+    trace_mutex_lock(&q->lock, "lock:cmd_queue");
+
+    if (q->count == q->cap) {
+        // Grow and unwrap so the FIFO order starts at index 0
+        size_t new_cap = q->cap * 2;
+        void **grown = malloc(new_cap * sizeof(void*));
+        if (!grown) {
+            pthread_mutex_unlock(&q->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < q->count; i++) {
+            grown[i] = q->items[(q->head + i) % q->cap];
+        }
+        free(q->items);
+        q->items = grown;
+        q->cap = new_cap;
+        q->head = 0;
+    }
+
+    q->items[(q->head + q->count) % q->cap] = item;
+    q->count++;
+
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+void* cq_pop(cmd_queue_t *q, int timeout_ms) {
+    trace_mutex_lock(&q->lock, "lock:cmd_queue");
+
+    if (q->count == 0 && timeout_ms > 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (q->count == 0) {
+            if (pthread_cond_timedwait(&q->not_empty, &q->lock, &deadline) == ETIMEDOUT) break;
+        }
+    }
+
+    void *item = NULL;
+    if (q->count > 0) {
+        item = q->items[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->count--;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return item;
+}
+
+size_t cq_count(cmd_queue_t *q) {
+    trace_mutex_lock(&q->lock, "lock:cmd_queue");
+    size_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
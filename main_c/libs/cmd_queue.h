@@ -0,0 +1,32 @@
+/**
+ * @file Drivers/cmd_queue.h
+ * @brief Unbounded FIFO of pointers between the ZMQ listener and the main loop
+ */
+#ifndef CMD_QUEUE_H
+#define CMD_QUEUE_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+typedef struct {
+    void **items;
+    size_t cap;
+    size_t head;
+    size_t count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+} cmd_queue_t;
+
+int cq_init(cmd_queue_t *q, size_t initial_cap);
+void cq_free(cmd_queue_t *q);
+
+// Appends an item, growing the storage if needed. Returns -1 only on OOM.
+int cq_push(cmd_queue_t *q, void *item);
+
+// Removes the oldest item, waiting up to timeout_ms (0 = don't wait).
+// Returns NULL on timeout.
+void* cq_pop(cmd_queue_t *q, int timeout_ms);
+
+size_t cq_count(cmd_queue_t *q);
+
+#endif
@@ -27,11 +27,50 @@ typedef enum {
     BARTLETT_TYPE
 }PsdWindowType_t;
 
+typedef enum {
+    PSD_UNIT_DENSITY,   // Raw V^2/Hz, no conversion
+    PSD_UNIT_DBM,
+    PSD_UNIT_DBUV,
+    PSD_UNIT_DBMV,
+    PSD_UNIT_WATTS,
+    PSD_UNIT_VOLTS
+}PsdUnit_t;
+
+/** Uniform frequency axis: f[i] = start_hz + i * step_hz, i < n */
+typedef struct {
+    double start_hz;
+    double step_hz;
+    int n;
+}PsdAxis_t;
+
+typedef enum {
+    OUTPUT_JSON,        // cJSON document on the "data" topic
+    OUTPUT_BINARY,      // Multipart header + float32 bins (psd_wire.h)
+    OUTPUT_SHM          // Shared-memory ring slot + index notification (psd_shm.h)
+}PsdOutputFormat_t;
+
+/** Payload encoding of the binary output (see psd_wire.h) */
+typedef enum {
+    PSD_WIRE_F32 = 0,   // Raw float32 bins
+    PSD_WIRE_Q16 = 1,   // int16 codes (default 0.01 dB), Rice coded
+    PSD_WIRE_Q8  = 2    // uint8 codes at a configurable step, Rice coded
+}PsdWireEncoding_t;
+
+typedef enum {
+    FFT_SIZE_POW2,      // Round nperseg up to a power of two
+    FFT_SIZE_SMOOTH     // Smallest 2/3/5/7-smooth size meeting the RBW
+}PsdFftSizing_t;
+
 typedef struct {
     PsdWindowType_t window_type;
+    double window_param;    // Kaiser beta / Tukey alpha (0 = default)
     double sample_rate;
     int nperseg;
     int noverlap;
+    int decimation;         // DDC ratio (<= 1 disables the DDC stage)
+    double nco_offset_hz;   // DDC mix offset relative to the tuned center
+    double rbw_actual;      // RBW delivered by the chosen nperseg and window
+    bool exact_log;         // Output stage uses libm log10 instead of the fast one
 }PsdConfig_t;
 
 
@@ -44,9 +83,18 @@ typedef struct {
     double overlap;
     int ppm_error;
     PsdWindowType_t window_type;
+    double window_param;
     double span;
     int rbw;
+    double nco_offset_hz;
+    PsdFftSizing_t fft_sizing;
+    bool exact_log;
+    PsdOutputFormat_t output_format;
+    PsdWireEncoding_t wire_encoding;
+    double quant_step_db;   // Quantization step for Q16/Q8 (0 = default)
+    int keyframe_interval;  // Frames between keyframes for delta coding
     char *scale;
+    char *request_id;       // Echoed with the results (NULL if not given)
 }DesiredCfg_t;
 
 typedef struct {
@@ -0,0 +1,124 @@
+/**
+ * @file Modules/latency_hist.c
+ */
+
+#define _GNU_SOURCE
+
+#include "latency_hist.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LAT_SUB_BITS     5
+#define LAT_SUB_COUNT    (1 << LAT_SUB_BITS)          // Buckets per power of two
+#define LAT_LINEAR       (2 * LAT_SUB_COUNT)          // Exact buckets: 0..63
+#define LAT_BUCKETS      (LAT_LINEAR + (64 - LAT_SUB_BITS - 1) * LAT_SUB_COUNT)
+
+typedef struct {
+    uint64_t counts[LAT_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+    uint64_t sum;
+} LatHist_t;
+
+static LatHist_t hists[LAT_STAGE_COUNT];
+
+static const char *stage_names[LAT_STAGE_COUNT] = {
+    "wait_cmd", "retune", "first_sample", "fill", "load_iq",
+    "fft", "scale", "encode", "publish", "log", "cycle"
+};
+
+uint64_t lat_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bucket_of(uint64_t v) {
+    if (v < LAT_LINEAR) return (int)v;
+    int msb = 63 - __builtin_clzll(v);          // >= LAT_SUB_BITS + 1
+    int shift = msb - LAT_SUB_BITS;
+    int top = (int)(v >> shift);                // In [LAT_SUB_COUNT, 2 * LAT_SUB_COUNT)
+    return LAT_LINEAR + (msb - LAT_SUB_BITS - 1) * LAT_SUB_COUNT + (top - LAT_SUB_COUNT);
+}
+
+// Midpoint of a bucket's range
+static uint64_t bucket_value(int idx) {
+    if (idx < LAT_LINEAR) return (uint64_t)idx;
+    int g = (idx - LAT_LINEAR) / LAT_SUB_COUNT;
+    int top = LAT_SUB_COUNT + (idx - LAT_LINEAR) % LAT_SUB_COUNT;
+    int shift = g + 1;
+    return ((uint64_t)top << shift) + ((1ULL << shift) >> 1);
+}
+
+void lat_record(LatStage_t stage, uint64_t ns) {
+    if ((unsigned)stage >= LAT_STAGE_COUNT) return;
+    LatHist_t *h = &hists[stage];
+    h->counts[bucket_of(ns)]++;
+    h->total++;
+    h->sum += ns;
+    if (ns > h->max) h->max = ns;
+}
+
+uint64_t lat_record_since(LatStage_t stage, uint64_t start_ns) {
+    uint64_t now = lat_now_ns();
+    lat_record(stage, now > start_ns ? now - start_ns : 0);
+    return now;
+}
+
+uint64_t lat_percentile(LatStage_t stage, double q) {
+    if ((unsigned)stage >= LAT_STAGE_COUNT) return 0;
+    const LatHist_t *h = &hists[stage];
+    if (h->total == 0) return 0;
+    if (q >= 1.0) return h->max;
+
+    uint64_t rank = (uint64_t)(q * (double)h->total);
+    if (rank >= h->total) rank = h->total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > rank) {
+            uint64_t v = bucket_value(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+char* lat_stats_json(void) {
+    size_t cap = 256 + LAT_STAGE_COUNT * 160;
+    char *buf = malloc(cap);
+    if (!buf) return NULL;
+
+    size_t len = (size_t)snprintf(buf, cap, "{\"stages\":{");
+    for (int s = 0; s < LAT_STAGE_COUNT && len < cap; s++) {
+        const LatHist_t *h = &hists[s];
+        len += (size_t)snprintf(buf + len, cap - len,
+                   "%s\"%s\":{\"count\":%llu,\"mean_ms\":%.3f,\"p50_ms\":%.3f,"
+                   "\"p99_ms\":%.3f,\"p999_ms\":%.3f,\"max_ms\":%.3f}",
+                   s ? "," : "", stage_names[s], (unsigned long long)h->total,
+                   h->total ? (double)h->sum / h->total / 1e6 : 0.0,
+                   lat_percentile(s, 0.50) / 1e6, lat_percentile(s, 0.99) / 1e6,
+                   lat_percentile(s, 0.999) / 1e6, h->max / 1e6);
+    }
+    if (len < cap) snprintf(buf + len, cap - len, "}}");
+    return buf;
+}
+
+void lat_dump(FILE *out) {
+    fprintf(out, "\n[LATENCY] %-13s %8s %10s %10s %10s %10s\n",
+            "stage", "count", "p50_ms", "p99_ms", "p999_ms", "max_ms");
+    for (int s = 0; s < LAT_STAGE_COUNT; s++) {
+        const LatHist_t *h = &hists[s];
+        fprintf(out, "[LATENCY] %-13s %8llu %10.3f %10.3f %10.3f %10.3f\n",
+                stage_names[s], (unsigned long long)h->total,
+                lat_percentile(s, 0.50) / 1e6, lat_percentile(s, 0.99) / 1e6,
+                lat_percentile(s, 0.999) / 1e6, h->max / 1e6);
+    }
+    fflush(out);
+}
+
+void lat_reset(void) {
+    memset(hists, 0, sizeof(hists));
+}
@@ -0,0 +1,63 @@
+/**
+ * @file Modules/latency_hist.h
+ * @brief Per-stage latency histograms for the acquisition/DSP pipeline
+ *
+ * Log-bucketed (HDR style): values below 64 ns are exact, above that each
+ * power of two is split into 32 buckets, so any reported percentile is
+ * within ~3% of the true value. Recording is O(1) and allocation free.
+ * Histograms are cumulative since start (or the last lat_reset).
+ */
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    LAT_WAIT_CMD,       // Idle until a job is available
+    LAT_RETUNE,         // hackrf_apply_cfg
+    LAT_FIRST_SAMPLE,   // hackrf_start_rx -> first RX callback
+    LAT_FILL,           // First sample -> ring buffer full
+    LAT_LOAD_IQ,        // load_iq_from_buffer
+    LAT_FFT,            // DDC + windowed FFT accumulation
+    LAT_SCALE,          // Output stage: shift, scaling, units
+    LAT_ENCODE,         // JSON build / binary encode
+    LAT_PUBLISH,        // zpub send
+    LAT_LOG,            // Metrics record push
+    LAT_CYCLE,          // Whole job, retune to logged
+    LAT_STAGE_COUNT
+} LatStage_t;
+
+#define LAT_STATS_TOPIC "stats"
+
+uint64_t lat_now_ns(void);
+
+/**
+ * @brief Adds one sample (nanoseconds) to a stage. Not thread-safe: all
+ * stages are recorded from the main loop.
+ */
+void lat_record(LatStage_t stage, uint64_t ns);
+
+/** Convenience: records now - start_ns and returns now */
+uint64_t lat_record_since(LatStage_t stage, uint64_t start_ns);
+
+/**
+ * @brief Value (ns) at quantile q in [0, 1] of a stage; 0 if empty.
+ */
+uint64_t lat_percentile(LatStage_t stage, double q);
+
+/**
+ * @brief JSON object {"stage": {"count", "p50_ms", "p99_ms", "p999_ms", "max_ms"}, ...}.
+ * Caller frees the string.
+ */
+char* lat_stats_json(void);
+
+/**
+ * @brief Human-readable table of every stage.
+ */
+void lat_dump(FILE *out);
+
+void lat_reset(void);
+
+#endif
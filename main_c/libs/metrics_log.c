@@ -0,0 +1,328 @@
+/**
+ * @file Modules/metrics_log.c
+ */
+
+#define _GNU_SOURCE
+
+#include "metrics_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <spawn.h>
+#include <sys/sysinfo.h>
+#include <sys/statvfs.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+#define METRICS_POLL_US     20000
+#define METRICS_IO_BUF      (64 * 1024)
+
+_Static_assert((METRICS_QUEUE_LEN & (METRICS_QUEUE_LEN - 1)) == 0, "queue length must be a power of two");
+
+typedef struct {
+    double cpu_usage_percent;
+    unsigned long ram_used_mb;
+    unsigned long ram_total_mb;
+    unsigned long swap_used_mb;
+    double disk_usage_percent;
+} SystemSample_t;
+
+// SPSC ring: head written by the producer only, tail by the writer only
+static MetricsRecord_t queue[METRICS_QUEUE_LEN];
+static _Atomic size_t q_head = 0;
+static _Atomic size_t q_tail = 0;
+static _Atomic unsigned long q_dropped = 0;
+
+static MetricsLogCfg_t log_cfg;
+static char folder[256];
+static pthread_t writer_thread;
+static atomic_bool running = false;
+
+// Writer-thread state
+static FILE *csv_fp = NULL;
+static char csv_filename[512];
+static unsigned file_part = 0;     // Rotations within this run
+static char *io_buf = NULL;
+static SystemSample_t last_sample;
+static unsigned long long prev_user, prev_nice, prev_system, prev_idle;
+static unsigned long long prev_iowait, prev_irq, prev_softirq, prev_steal;
+
+// ----------------------------------------------------------------------
+// System sampling (writer thread only)
+// ----------------------------------------------------------------------
+
+static double get_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+// Retrieve MAC address (Try wlan0, fallback to eth0)
+static void get_mac_address(char *buffer) {
+    char path[128];
+    FILE *f;
+    const char *interfaces[] = {"wlan0", "eth0", "en0"};
+
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "/sys/class/net/%s/address", interfaces[i]);
+        f = fopen(path, "r");
+        if (f) {
+            if (fgets(buffer, 18, f)) {
+                fclose(f);
+                buffer[strcspn(buffer, "\n")] = 0; // Remove newline
+                return;
+            }
+            fclose(f);
+        }
+    }
+    strcpy(buffer, "UNKNOWN_MAC");
+}
+
+// Calculate CPU usage delta since the previous sample
+static double get_cpu_load(void) {
+    FILE *fp = fopen("/proc/stat", "r");
+    if (!fp) return 0.0;
+
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    char buffer[1024];
+    if (!fgets(buffer, sizeof(buffer), fp)) { fclose(fp); return 0.0; }
+    sscanf(buffer, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu",
+           &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    fclose(fp);
+
+    unsigned long long prev_idle_total = prev_idle + prev_iowait;
+    unsigned long long idle_total = idle + iowait;
+
+    unsigned long long prev_non_idle = prev_user + prev_nice + prev_system + prev_irq + prev_softirq + prev_steal;
+    unsigned long long non_idle = user + nice + system + irq + softirq + steal;
+
+    double total_d = (double)((idle_total + non_idle) - (prev_idle_total + prev_non_idle));
+    double id_d = (double)(idle_total - prev_idle_total);
+
+    prev_user = user; prev_nice = nice; prev_system = system; prev_idle = idle;
+    prev_iowait = iowait; prev_irq = irq; prev_softirq = softirq; prev_steal = steal;
+
+    if (total_d == 0) return 0.0;
+    return ((total_d - id_d) / total_d) * 100.0;
+}
+
+static void sample_system(SystemSample_t *m) {
+    struct sysinfo si;
+    if (sysinfo(&si) == 0) {
+        m->ram_used_mb = (unsigned long)((si.totalram - si.freeram) * si.mem_unit / 1024 / 1024);
+        m->ram_total_mb = (unsigned long)(si.totalram * si.mem_unit / 1024 / 1024);
+        m->swap_used_mb = (unsigned long)((si.totalswap - si.freeswap) * si.mem_unit / 1024 / 1024);
+    }
+
+    struct statvfs st;
+    if (statvfs(".", &st) == 0 && st.f_blocks > 0) {
+        m->disk_usage_percent = (1.0 - ((double)st.f_bfree / (double)st.f_blocks)) * 100.0;
+    }
+
+    m->cpu_usage_percent = get_cpu_load();
+}
+
+// ----------------------------------------------------------------------
+// File handling (writer thread only)
+// ----------------------------------------------------------------------
+
+static void compress_file(const char *path) {
+    char *argv[] = { "gzip", "-f", (char*)path, NULL };
+    pid_t pid;
+    if (posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ) != 0) {
+        fprintf(stderr, "[METRICS] Warning: could not spawn gzip for %s\n", path);
+    }
+}
+
+static void reap_children(void) {
+    while (waitpid(-1, NULL, WNOHANG) > 0) {}
+}
+
+static int open_new_file(void) {
+    char mac[32];
+    get_mac_address(mac);
+    // Sanitize MAC for filename
+    for (int i = 0; mac[i]; i++) { if (mac[i] == ':') mac[i] = '-'; }
+
+    time_t t = time(NULL);
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    char part[16] = "";
+    if (file_part > 0) snprintf(part, sizeof(part), "_p%u", file_part);
+
+    snprintf(csv_filename, sizeof(csv_filename),
+             "%s/%04d%02d%02d_%02d%02d%02d_%s%s.csv",
+             folder,
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+             tm.tm_hour, tm.tm_min, tm.tm_sec,
+             mac, part);
+
+    csv_fp = fopen(csv_filename, "a");
+    if (!csv_fp) {
+        fprintf(stderr, "[METRICS] Error: cannot open %s\n", csv_filename);
+        return -1;
+    }
+    setvbuf(csv_fp, io_buf, _IOFBF, METRICS_IO_BUF);
+
+    fseek(csv_fp, 0, SEEK_END);
+    if (ftell(csv_fp) == 0) {
+        fprintf(csv_fp, "Timestamp_Epoch,Acq_Time_ms,PSD_Calc_Time_ms,"
+                        "CPU_Load_Pct,RAM_Used_MB,RAM_Total_MB,Swap_Used_MB,Disk_Usage_Pct,"
+                        "CenterFreq_Hz,RBW_Hz,SampleRate_Hz,Span_Hz,Overlap,Scale,Window,LNA,VGA,Amp,PSD_Bins\n");
+    }
+    return 0;
+}
+
+static void rotate_if_needed(void) {
+    if (!csv_fp || ftell(csv_fp) < log_cfg.max_file_bytes) return;
+
+    fclose(csv_fp);
+    csv_fp = NULL;
+    if (log_cfg.compress) compress_file(csv_filename);
+
+    file_part++;
+    open_new_file();
+}
+
+static void write_record(const MetricsRecord_t *r) {
+    if (!csv_fp) return;
+    const SystemSample_t *m = &last_sample;
+
+    fprintf(csv_fp, "%ld,%.2f,%.2f,%.2f,%lu,%lu,%lu,%.2f,"
+                    "%" PRIu64 ",%d,%.0f,%.0f,%.2f,%s,%d,%d,%d,%d,%d\n",
+            (long)r->timestamp,
+            r->acq_time_ms,
+            r->dsp_time_ms,
+            m->cpu_usage_percent,
+            m->ram_used_mb,
+            m->ram_total_mb,
+            m->swap_used_mb,
+            m->disk_usage_percent,
+            r->center_freq,
+            r->rbw,
+            r->sample_rate,
+            r->span,
+            r->overlap,
+            r->scale,
+            r->window_type,
+            r->lna_gain,
+            r->vga_gain,
+            r->amp_enabled,
+            r->psd_bins);
+}
+
+// Pops everything queued so far; returns the number of rows written
+static int drain_queue(void) {
+    size_t tail = atomic_load_explicit(&q_tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&q_head, memory_order_acquire);
+    int n = 0;
+
+    while (tail != head) {
+        write_record(&queue[tail & (METRICS_QUEUE_LEN - 1)]);
+        tail++;
+        n++;
+    }
+    atomic_store_explicit(&q_tail, tail, memory_order_release);
+    return n;
+}
+
+static void* writer_main(void *arg) {
+    (void)arg;
+    double last_sample_ms = 0.0, last_flush_ms = get_time_ms();
+    bool dirty = false;
+
+    sample_system(&last_sample);    // Primes the CPU delta
+
+    while (atomic_load(&running) || atomic_load(&q_head) != atomic_load(&q_tail)) {
+        double now = get_time_ms();
+        if (now - last_sample_ms >= METRICS_SAMPLE_MS) {
+            sample_system(&last_sample);
+            last_sample_ms = now;
+            reap_children();
+        }
+
+        if (drain_queue() > 0) dirty = true;
+
+        if (dirty && now - last_flush_ms >= METRICS_FLUSH_MS) {
+            if (csv_fp) fflush(csv_fp);
+            rotate_if_needed();
+            last_flush_ms = now;
+            dirty = false;
+
+            unsigned long dropped = atomic_exchange(&q_dropped, 0);
+            if (dropped) fprintf(stderr, "[METRICS] Warning: %lu records dropped (queue full)\n", dropped);
+        }
+
+        usleep(METRICS_POLL_US);
+    }
+
+    if (csv_fp) {
+        fclose(csv_fp);
+        csv_fp = NULL;
+    }
+    reap_children();
+    return NULL;
+}
+
+// ----------------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------------
+
+int metrics_log_start(const MetricsLogCfg_t *cfg) {
+    if (!cfg || !cfg->folder) return -1;
+
+    log_cfg = *cfg;
+    if (log_cfg.max_file_bytes <= 0) log_cfg.max_file_bytes = METRICS_MAX_FILE_BYTES;
+    snprintf(folder, sizeof(folder), "%s", cfg->folder);
+
+    struct stat st = {0};
+    if (stat(folder, &st) == -1) {
+        mkdir(folder, 0777);
+    }
+
+    io_buf = malloc(METRICS_IO_BUF);
+    if (!io_buf || open_new_file() != 0) {
+        free(io_buf);
+        io_buf = NULL;
+        return -1;
+    }
+
+    atomic_store(&running, true);
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        atomic_store(&running, false);
+        fclose(csv_fp);
+        csv_fp = NULL;
+        return -1;
+    }
+    printf("[METRICS] Async writer started (%s)\n", csv_filename);
+    return 0;
+}
+
+bool metrics_log_push(const MetricsRecord_t *rec) {
+    size_t head = atomic_load_explicit(&q_head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&q_tail, memory_order_acquire);
+
+    if (head - tail >= METRICS_QUEUE_LEN) {
+        atomic_fetch_add_explicit(&q_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    queue[head & (METRICS_QUEUE_LEN - 1)] = *rec;
+    atomic_store_explicit(&q_head, head + 1, memory_order_release);
+    return true;
+}
+
+void metrics_log_stop(void) {
+    if (!atomic_load(&running)) return;
+    atomic_store(&running, false);
+    pthread_join(writer_thread, NULL);
+    free(io_buf);
+    io_buf = NULL;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file Modules/metrics_log.h
+ * @brief Asynchronous per-cycle metrics logger (CSV with rotation)
+ *
+ * The DSP thread only copies a fixed-size record into a lock-free SPSC
+ * queue. A background thread samples system stats (CPU, RAM, swap, disk)
+ * at its own interval, formats the rows into a buffered CSV file, rotates
+ * it by size and gzips the closed files in a child process.
+ */
+
+#ifndef METRICS_LOG_H
+#define METRICS_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define METRICS_QUEUE_LEN        1024        // Records; must be a power of two
+#define METRICS_SAMPLE_MS        1000        // System stats sampling period
+#define METRICS_FLUSH_MS         1000        // Max time a row stays in the stdio buffer
+#define METRICS_MAX_FILE_BYTES   (16L * 1024 * 1024)
+
+/** One measurement cycle, as queued by the hot path */
+typedef struct {
+    time_t timestamp;
+    double acq_time_ms;
+    double dsp_time_ms;
+    uint64_t center_freq;
+    int rbw;
+    double sample_rate;
+    double span;
+    double overlap;
+    char scale[8];
+    int window_type;
+    int lna_gain;
+    int vga_gain;
+    int amp_enabled;
+    int psd_bins;
+} MetricsRecord_t;
+
+typedef struct {
+    const char *folder;         // Created if missing
+    long max_file_bytes;        // Rotate above this size (0 = default)
+    bool compress;              // gzip rotated files
+} MetricsLogCfg_t;
+
+/**
+ * @brief Starts the writer thread. Returns 0 on success.
+ */
+int metrics_log_start(const MetricsLogCfg_t *cfg);
+
+/**
+ * @brief Queues one record (single producer). Never blocks: when the queue
+ * is full the record is dropped and counted.
+ * @return true if queued.
+ */
+bool metrics_log_push(const MetricsRecord_t *rec);
+
+/**
+ * @brief Drains the queue, flushes and joins the writer thread.
+ */
+void metrics_log_stop(void);
+
+#endif
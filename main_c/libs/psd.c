@@ -2,13 +2,19 @@
  * @file Modules/psd.c
  */
 
+#define _POSIX_C_SOURCE 200809L     // strdup, strcasecmp under -std=c11
+
 #include "psd.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <math.h>
 #include <fftw3.h>
-#include <alloca.h>
 #include <complex.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -40,95 +46,264 @@ void free_signal_iq(signal_iq_t* signal) {
 // Scaling Logic (Modified to match your reference)
 // ----------------------------------------------------------------------
 
+PsdUnit_t psd_parse_unit(const char* scale_str) {
+    if (!scale_str) return PSD_UNIT_DBM;
+    if (strcmp(scale_str, "dBuV") == 0) return PSD_UNIT_DBUV;
+    if (strcmp(scale_str, "dBmV") == 0) return PSD_UNIT_DBMV;
+    if (strcmp(scale_str, "W") == 0)    return PSD_UNIT_WATTS;
+    if (strcmp(scale_str, "V") == 0)    return PSD_UNIT_VOLTS;
+    return PSD_UNIT_DBM;
+}
+
+// Fast log10: x = 2^e * m with m folded into [sqrt(1/2), sqrt(2)),
+// ln(m) = 2*atanh(s), s = (m-1)/(m+1), |s| <= 0.1716, series to s^5.
+// Truncation error |2 s^7 / 7| <= 1.3e-6 in ln(x), i.e. <= 6e-6 dB on
+// 10*log10(x) -- far inside the 0.001 dB budget for display/metrics.
+#define LN2_OVER_LN10   0.30102999566398119521
+#define INV_LN10        0.43429448190325182765
+#define SQRT2           1.41421356237309504880
+
+static inline double fast_log10(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    int64_t e = (int64_t)((bits >> 52) & 0x7ff) - 1023;
+    bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+
+    // Branchless fold of [sqrt2, 2) down to [sqrt2/2, 1)
+    int big = (m > SQRT2);
+    m *= big ? 0.5 : 1.0;
+    e += big;
+
+    double s = (m - 1.0) / (m + 1.0);
+    double s2 = s * s;
+    double ln_m = 2.0 * s * (1.0 + s2 * (1.0 / 3.0 + s2 * (1.0 / 5.0)));
+    return (double)e * LN2_OVER_LN10 + ln_m * INV_LN10;
+}
+
 /**
- * @brief Scales PSD. 
- * CRITICAL: This uses the user's formula P = PSD[i] / 50.
+ * @brief Unit conversion kernel over a contiguous block (in may equal out).
+ *
+ * Folded form of the reference formula (P = PSD * scale / 50, clamped at
+ * 1e-20 W, dBm = 10*log10(P*1000)):
+ *   dB units:  out = 10*log10(max(in*scale, 50e-20)) + (10*log10(1000/50) + unit offset)
+ *   W:         out = max(in*scale/50, 1e-20)
+ *   V:         out = sqrt(max(in*scale, 50e-20))
  * It does NOT multiply by RBW, ensuring the noise floor stays at ~-70dBm.
  */
-int scale_psd(double* psd, int nperseg, const char* scale_str) {
-    if (!psd) return -1;
-    
+static void psd_scale_kernel(const double* in, double scale, PsdUnit_t unit, bool exact,
+                             double* out, int n) {
     const double Z = 50.0; // Impedance
-    
-    typedef enum { UNIT_DBM, UNIT_DBUV, UNIT_DBMV, UNIT_WATTS, UNIT_VOLTS } Unit_t;
-    Unit_t unit = UNIT_DBM;
-    
-    if (scale_str) {
-        if (strcmp(scale_str, "dBuV") == 0) unit = UNIT_DBUV;
-        else if (strcmp(scale_str, "dBmV") == 0) unit = UNIT_DBMV;
-        else if (strcmp(scale_str, "W") == 0)    unit = UNIT_WATTS;
-        else if (strcmp(scale_str, "V") == 0)    unit = UNIT_VOLTS;
-    }
-
-    for (int i = 0; i < nperseg; i++) {
-        
-        // 1. YOUR BASE FORMULA (Direct V^2 to Watts)
-        // We assume psd[i] is already V^2 magnitude, not density.
-        double p_watts = psd[i] / Z;
-
-        // Safety for log10
-        if (p_watts < 1.0e-20) p_watts = 1.0e-20; 
-
-        // 2. CALCULATE dBm (The Anchor)
-        // Formula: 10 * log10(Watts * 1000)
-        double val_dbm = 10.0 * log10(p_watts * 1000.0);
-
-        // 3. CONVERT TO TARGET (Relative to your dBm)
-        switch (unit) {
-            case UNIT_DBUV:
-                // dBuV = dBm + 107
-                psd[i] = val_dbm + 107.0;
-                break;
-            case UNIT_DBMV:
-                // dBmV = dBm + 47
-                psd[i] = val_dbm + 47.0;
-                break;
-            case UNIT_WATTS:
-                psd[i] = p_watts;
-                break;
-            case UNIT_VOLTS:
-                // V = sqrt(P * R)
-                psd[i] = sqrt(p_watts * Z);
-                break;
-            case UNIT_DBM:
-            default:
-                psd[i] = val_dbm;
-                break;
-        }
+    const double floor_v2 = 1.0e-20 * Z;
+
+    if (unit == PSD_UNIT_DENSITY) {
+        for (int i = 0; i < n; i++) out[i] = in[i] * scale;
+        return;
+    }
+    if (unit == PSD_UNIT_WATTS) {
+        double k = scale / Z;
+        for (int i = 0; i < n; i++) out[i] = fmax(in[i] * k, 1.0e-20);
+        return;
+    }
+    if (unit == PSD_UNIT_VOLTS) {
+        for (int i = 0; i < n; i++) out[i] = sqrt(fmax(in[i] * scale, floor_v2));
+        return;
+    }
+
+    double offset = 10.0 * log10(1000.0 / Z);       // dBm anchor
+    if (unit == PSD_UNIT_DBUV) offset += 107.0;     // dBuV = dBm + 107
+    if (unit == PSD_UNIT_DBMV) offset += 47.0;      // dBmV = dBm + 47
+
+    if (exact) {
+        for (int i = 0; i < n; i++) out[i] = 10.0 * log10(fmax(in[i] * scale, floor_v2)) + offset;
+    } else {
+        for (int i = 0; i < n; i++) out[i] = 10.0 * fast_log10(fmax(in[i] * scale, floor_v2)) + offset;
     }
+}
+
+/**
+ * @brief Scales PSD in place. Uses the exact libm log10.
+ */
+int scale_psd(double* psd, int nperseg, const char* scale_str) {
+    if (!psd) return -1;
+
+    psd_scale_kernel(psd, 1.0, psd_parse_unit(scale_str), true, psd, nperseg);
     return 0;
 }
 
-double get_window_enbw_factor(PsdWindowType_t type) {
+int psd_next_smooth_size(int n) {
+    if (n <= 1) return 1;
+    for (int m = n; m > 0; m++) {
+        int r = m;
+        while (r % 2 == 0) r /= 2;
+        while (r % 3 == 0) r /= 3;
+        while (r % 5 == 0) r /= 5;
+        while (r % 7 == 0) r /= 7;
+        if (r == 1) return m;
+    }
+    return n;
+}
+
+// ----------------------------------------------------------------------
+// Window Cache
+// ----------------------------------------------------------------------
+
+#define PSD_WINDOW_CACHE_SIZE 8
+
+#define KAISER_DEFAULT_BETA  8.6
+#define TUKEY_DEFAULT_ALPHA  0.5
+#define ENBW_REFERENCE_LEN   4096
+
+static PsdWindow_t window_cache[PSD_WINDOW_CACHE_SIZE];
+static unsigned long window_cache_clock = 0;
+static unsigned long window_cache_used[PSD_WINDOW_CACHE_SIZE];
+static pthread_mutex_t window_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+static double window_default_param(PsdWindowType_t type, double param) {
+    if (param > 0.0) return param;
     switch (type) {
-        case RECTANGULAR_TYPE: return 1.000;
-        case HAMMING_TYPE:     return 1.363;
-        case HANN_TYPE:        return 1.500;
-        case BLACKMAN_TYPE:    return 1.730;
-        default:               return 1.0;
+        case KAISER_TYPE: return KAISER_DEFAULT_BETA;
+        case TUKEY_TYPE:  return TUKEY_DEFAULT_ALPHA;
+        default:          return 0.0;
     }
 }
 
-static void generate_window(PsdWindowType_t window_type, double* window_buffer, int window_length) {
+static void generate_window(PsdWindowType_t window_type, double param, double* window_buffer, int window_length) {
+    double den = (window_length > 1) ? (double)(window_length - 1) : 1.0;
+    double i0_beta = (window_type == KAISER_TYPE) ? bessel_i0(param) : 1.0;
+
     for (int n = 0; n < window_length; n++) {
+        double x = (2.0 * M_PI * n) / den;
         switch (window_type) {
             case HANN_TYPE:
-                window_buffer[n] = 0.5 * (1 - cos((2.0 * M_PI * n) / (window_length - 1)));
+                window_buffer[n] = 0.5 * (1 - cos(x));
                 break;
             case RECTANGULAR_TYPE:
                 window_buffer[n] = 1.0;
                 break;
             case BLACKMAN_TYPE:
-                window_buffer[n] = 0.42 - 0.5 * cos((2.0 * M_PI * n) / (window_length - 1)) + 0.08 * cos((4.0 * M_PI * n) / (window_length - 1));
+                window_buffer[n] = 0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x);
+                break;
+            case FLAT_TOP_TYPE:
+                // SciPy/Matlab 5-term flat-top (amplitude error < 0.01 dB)
+                window_buffer[n] = 0.21557895 - 0.41663158 * cos(x) + 0.277263158 * cos(2.0 * x)
+                                 - 0.083578947 * cos(3.0 * x) + 0.006947368 * cos(4.0 * x);
+                break;
+            case KAISER_TYPE: {
+                double r = 2.0 * n / den - 1.0;
+                window_buffer[n] = bessel_i0(param * sqrt(fmax(0.0, 1.0 - r * r))) / i0_beta;
+                break;
+            }
+            case TUKEY_TYPE: {
+                // param = alpha, fraction of the window inside the cosine tapers
+                double edge = param * den / 2.0;
+                if (param <= 0.0 || (n >= edge && n <= den - edge)) {
+                    window_buffer[n] = 1.0;
+                } else if (n < edge) {
+                    window_buffer[n] = 0.5 * (1.0 + cos(M_PI * (n / edge - 1.0)));
+                } else {
+                    window_buffer[n] = 0.5 * (1.0 + cos(M_PI * ((den - n) / edge - 1.0)));
+                }
+                break;
+            }
+            case BARTLETT_TYPE:
+                window_buffer[n] = 1.0 - fabs(2.0 * n / den - 1.0);
                 break;
             case HAMMING_TYPE:
             default:
-                window_buffer[n] = 0.54 - 0.46 * cos((2.0 * M_PI * n) / (window_length - 1));
+                window_buffer[n] = 0.54 - 0.46 * cos(x);
                 break;
         }
     }
 }
 
+const PsdWindow_t* psd_window_acquire(PsdWindowType_t type, int length, double param) {
+    if (length <= 0) return NULL;
+    param = window_default_param(type, param);
+
+    trace_mutex_lock(&window_cache_lock, "lock:window_cache");
+    window_cache_clock++;
+
+    int victim = -1;
+    for (int i = 0; i < PSD_WINDOW_CACHE_SIZE; i++) {
+        PsdWindow_t* w = &window_cache[i];
+        if (w->coeffs && w->type == type && w->length == length && w->param == param) {
+            w->refcount++;
+            window_cache_used[i] = window_cache_clock;
+            pthread_mutex_unlock(&window_cache_lock);
+            return w;
+        }
+        // Evict the least recently used entry nobody holds
+        if (w->refcount == 0 && (victim < 0 || window_cache_used[i] < window_cache_used[victim])) {
+            victim = i;
+        }
+    }
+
+    if (victim < 0) {
+        pthread_mutex_unlock(&window_cache_lock);
+        fprintf(stderr, "[PSD] ERROR: Window cache exhausted\n");
+        return NULL;
+    }
+
+    PsdWindow_t* w = &window_cache[victim];
+    double* coeffs = (double*)realloc(w->coeffs, length * sizeof(double));
+    if (!coeffs) {
+        pthread_mutex_unlock(&window_cache_lock);
+        return NULL;
+    }
+    generate_window(type, param, coeffs, length);
+
+    double sum = 0.0, sum_sq = 0.0;
+    for (int i = 0; i < length; i++) {
+        sum += coeffs[i];
+        sum_sq += coeffs[i] * coeffs[i];
+    }
+
+    w->type = type;
+    w->length = length;
+    w->param = param;
+    w->coeffs = coeffs;
+    w->u_norm = sum_sq / length;
+    w->enbw = (sum > 0.0) ? length * sum_sq / (sum * sum) : 1.0;
+    w->refcount = 1;
+    window_cache_used[victim] = window_cache_clock;
+
+    pthread_mutex_unlock(&window_cache_lock);
+    return w;
+}
+
+void psd_window_release(const PsdWindow_t* window) {
+    if (!window) return;
+    trace_mutex_lock(&window_cache_lock, "lock:window_cache");
+    PsdWindow_t* w = (PsdWindow_t*)window;
+    if (w->refcount > 0) w->refcount--;
+    pthread_mutex_unlock(&window_cache_lock);
+}
+
+double psd_window_enbw(PsdWindowType_t type, double param) {
+    const PsdWindow_t* w = psd_window_acquire(type, ENBW_REFERENCE_LEN, param);
+    if (!w) return 1.0;
+    double enbw = w->enbw;
+    psd_window_release(w);
+    return enbw;
+}
+
+double get_window_enbw_factor(PsdWindowType_t type) {
+    return psd_window_enbw(type, 0.0);
+}
+
 static PsdWindowType_t get_window_type_from_string(const char *window_str) {
     if (window_str == NULL) return HAMMING_TYPE; // Default
     
@@ -136,6 +311,11 @@ static PsdWindowType_t get_window_type_from_string(const char *window_str) {
     if (strcasecmp(window_str, "hann") == 0) return HANN_TYPE;
     if (strcasecmp(window_str, "blackman") == 0) return BLACKMAN_TYPE;
     if (strcasecmp(window_str, "rectangular") == 0) return RECTANGULAR_TYPE;
+    if (strcasecmp(window_str, "flattop") == 0) return FLAT_TOP_TYPE;
+    if (strcasecmp(window_str, "flat_top") == 0) return FLAT_TOP_TYPE;
+    if (strcasecmp(window_str, "kaiser") == 0) return KAISER_TYPE;
+    if (strcasecmp(window_str, "tukey") == 0) return TUKEY_TYPE;
+    if (strcasecmp(window_str, "bartlett") == 0) return BARTLETT_TYPE;
 
     printf("[PSD]ERROR: Window does not exist, returning rectangular");
 
@@ -143,24 +323,9 @@ static PsdWindowType_t get_window_type_from_string(const char *window_str) {
 }
 
 /**
- * Parses JSON string and fills the DesiredCfg_t struct.
- * Returns 0 on success, -1 on failure.
+ * Fills the DesiredCfg_t struct from an already parsed JSON object.
  */
-int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
-    if (json_string == NULL || target == NULL) {
-        return -1;
-    }
-
-    // Parse the JSON string
-    cJSON *root = cJSON_Parse(json_string);
-    if (root == NULL) {
-        const char *error_ptr = cJSON_GetErrorPtr();
-        if (error_ptr != NULL) {
-            fprintf(stderr, "Error before: %s\n", error_ptr);
-        }
-        return -1;
-    }
-
+static int parse_psd_config_obj(const cJSON *root, DesiredCfg_t *target) {
     // 1. Center Freq (uint64_t)
     cJSON *cf = cJSON_GetObjectItemCaseSensitive(root, "center_freq_hz");
     if (cJSON_IsNumber(cf)) {
@@ -214,6 +379,12 @@ int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
         target->window_type = RECTANGULAR_TYPE; // Default
     }
 
+    // 5b. Window shape parameter (double, optional): Kaiser beta / Tukey alpha
+    cJSON *win_param = cJSON_GetObjectItemCaseSensitive(root, "window_param");
+    if (cJSON_IsNumber(win_param)) {
+        target->window_param = win_param->valuedouble;
+    }
+
     // 6. LNA Gain (int)
     cJSON *lna = cJSON_GetObjectItemCaseSensitive(root, "lna_gain");
     if (cJSON_IsNumber(lna)) {
@@ -232,81 +403,727 @@ int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
         target->amp_enabled = cJSON_IsTrue(amp);
     }
 
-    // 9. PPM Error (Not in JSON, set default)
+    // 9. NCO offset for the DDC stage (double, optional)
+    cJSON *nco = cJSON_GetObjectItemCaseSensitive(root, "nco_offset_hz");
+    if (cJSON_IsNumber(nco)) {
+        target->nco_offset_hz = nco->valuedouble;
+    }
+
+    // 10. FFT sizing mode (string, optional): "pow2" (default) or "exact"
+    cJSON *sizing = cJSON_GetObjectItemCaseSensitive(root, "fft_sizing");
+    if (cJSON_IsString(sizing) && strcasecmp(sizing->valuestring, "exact") == 0) {
+        target->fft_sizing = FFT_SIZE_SMOOTH;
+    } else {
+        target->fft_sizing = FFT_SIZE_POW2;
+    }
+
+    // 11. Exact log10 in the output stage (bool, optional; default fast)
+    cJSON *exact_log = cJSON_GetObjectItemCaseSensitive(root, "exact_log");
+    if (cJSON_IsBool(exact_log)) {
+        target->exact_log = cJSON_IsTrue(exact_log);
+    }
+
+    // 12. Output format (string, optional): "json" (default), "binary" or "shm"
+    cJSON *fmt = cJSON_GetObjectItemCaseSensitive(root, "output_format");
+    if (cJSON_IsString(fmt) && strcasecmp(fmt->valuestring, "binary") == 0) {
+        target->output_format = OUTPUT_BINARY;
+    } else if (cJSON_IsString(fmt) && strcasecmp(fmt->valuestring, "shm") == 0) {
+        target->output_format = OUTPUT_SHM;
+    } else {
+        target->output_format = OUTPUT_JSON;
+    }
+
+    // Binary payload encoding: "f32" (default), "q16" or "q8"
+    cJSON *enc = cJSON_GetObjectItemCaseSensitive(root, "encoding");
+    target->wire_encoding = PSD_WIRE_F32;
+    if (cJSON_IsString(enc)) {
+        if (strcasecmp(enc->valuestring, "q16") == 0) target->wire_encoding = PSD_WIRE_Q16;
+        else if (strcasecmp(enc->valuestring, "q8") == 0) target->wire_encoding = PSD_WIRE_Q8;
+    }
+
+    cJSON *qstep = cJSON_GetObjectItemCaseSensitive(root, "quant_step_db");
+    target->quant_step_db = cJSON_IsNumber(qstep) ? qstep->valuedouble : 0.0;
+
+    cJSON *kint = cJSON_GetObjectItemCaseSensitive(root, "keyframe_interval");
+    target->keyframe_interval = cJSON_IsNumber(kint) ? (int)kint->valuedouble : 0;
+
+    // 13. Request id (string, optional): echoed back with the results
+    cJSON *rid = cJSON_GetObjectItemCaseSensitive(root, "request_id");
+    if (cJSON_IsString(rid) && rid->valuestring) {
+        target->request_id = strdup(rid->valuestring);
+    }
+
+    // 14. PPM Error (Not in JSON, set default)
     target->ppm_error = 0;
 
+    return 0;
+}
+
+static cJSON* parse_json_root(const char *json_string) {
+    cJSON *root = cJSON_Parse(json_string);
+    if (root == NULL) {
+        const char *error_ptr = cJSON_GetErrorPtr();
+        if (error_ptr != NULL) {
+            fprintf(stderr, "Error before: %s\n", error_ptr);
+        }
+    }
+    return root;
+}
+
+/**
+ * Parses JSON string and fills the DesiredCfg_t struct.
+ * Returns 0 on success, -1 on failure.
+ */
+int parse_psd_config(const char *json_string, DesiredCfg_t *target) {
+    if (json_string == NULL || target == NULL) {
+        return -1;
+    }
+
+    cJSON *root = parse_json_root(json_string);
+    if (root == NULL) return -1;
+
+    int rc = parse_psd_config_obj(root, target);
+
     // Clean up cJSON object
     cJSON_Delete(root);
-    return 0;
+    return rc;
+}
+
+/**
+ * Parses a single config or a batch:
+ *   {"request_id": "survey", "rbw_hz": ..., "measurements": [{"center_freq_hz": ...}, ...]}
+ * Each measurement inherits every top-level key it does not override. Items
+ * without their own request_id get "<request_id>/<index>".
+ * Returns the number of configs written to *targets (caller frees each with
+ * free_desired_psd and the array with free), or -1 on failure.
+ */
+int parse_psd_batch(const char *json_string, DesiredCfg_t **targets) {
+    if (json_string == NULL || targets == NULL) return -1;
+    *targets = NULL;
+
+    cJSON *root = parse_json_root(json_string);
+    if (root == NULL) return -1;
+
+    cJSON *list = cJSON_GetObjectItemCaseSensitive(root, "measurements");
+    if (!cJSON_IsArray(list)) {
+        DesiredCfg_t *one = calloc(1, sizeof(DesiredCfg_t));
+        int rc = (one && parse_psd_config_obj(root, one) == 0) ? 1 : -1;
+        cJSON_Delete(root);
+        if (rc < 0) {
+            free(one);
+            return -1;
+        }
+        *targets = one;
+        return 1;
+    }
+
+    int n = cJSON_GetArraySize(list);
+    DesiredCfg_t *out = calloc(n > 0 ? n : 1, sizeof(DesiredCfg_t));
+    if (!out) {
+        cJSON_Delete(root);
+        return -1;
+    }
+
+    // Defaults: the top-level object without the list itself
+    cJSON_DetachItemViaPointer(root, list);
+    cJSON *rid = cJSON_GetObjectItemCaseSensitive(root, "request_id");
+    const char *batch_id = cJSON_IsString(rid) ? rid->valuestring : "batch";
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        cJSON *item = cJSON_GetArrayItem(list, i);
+        if (!cJSON_IsObject(item)) continue;
+
+        cJSON *merged = cJSON_Duplicate(root, 1);
+        if (!merged) break;
+        for (cJSON *field = item->child; field; field = field->next) {
+            cJSON *copy = cJSON_Duplicate(field, 1);
+            if (!copy) continue;
+            if (cJSON_GetObjectItemCaseSensitive(merged, field->string)) {
+                cJSON_ReplaceItemInObjectCaseSensitive(merged, field->string, copy);
+            } else {
+                cJSON_AddItemToObject(merged, field->string, copy);
+            }
+        }
+
+        if (!cJSON_IsString(cJSON_GetObjectItemCaseSensitive(item, "request_id"))) {
+            char id[128];
+            snprintf(id, sizeof(id), "%s/%d", batch_id, i);
+            cJSON_DeleteItemFromObjectCaseSensitive(merged, "request_id");
+            cJSON_AddStringToObject(merged, "request_id", id);
+        }
+
+        if (parse_psd_config_obj(merged, &out[count]) == 0) {
+            count++;
+        } else {
+            free_desired_psd(&out[count]);
+            memset(&out[count], 0, sizeof(DesiredCfg_t));
+        }
+        cJSON_Delete(merged);
+    }
+
+    cJSON_Delete(list);
+    cJSON_Delete(root);
+    *targets = out;
+    return count;
 }
 
 // Helper function to free the memory allocated inside parse_psd_config
 void free_desired_psd(DesiredCfg_t *target) {
-    if (target && target->scale) {
+    if (!target) return;
+    if (target->scale) {
         free(target->scale);
         target->scale = NULL;
     }
+    if (target->request_id) {
+        free(target->request_id);
+        target->request_id = NULL;
+    }
 }
 
-static void fftshift(double* data, int n) {
-    int half = n / 2;
-    double* temp = (double*)alloca(half * sizeof(double));
-    memcpy(temp, data, half * sizeof(double));
-    memcpy(data, &data[half], (n - half) * sizeof(double));
-    memcpy(&data[n - half], temp, half * sizeof(double));
+// Stage timing of the last Welch run on this thread (see psd_last_timing)
+static _Thread_local PsdTiming_t last_timing;
+
+static uint64_t psd_clock_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
-void execute_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out) {
-    double complex* signal = signal_data->signal_iq;
-    size_t n_signal = signal_data->n_signal;
+void psd_last_timing(PsdTiming_t* out) {
+    if (out) *out = last_timing;
+}
+
+// FFTW's planner is not thread-safe; every plan create/destroy goes through this
+static pthread_mutex_t fftw_planner_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Welch accumulation of |X[k]|^2 in natural FFT order.
+ * @return Number of averaged segments, or -1 on failure.
+ */
+static int welch_accumulate(const signal_iq_t* signal_data, const PsdConfig_t* config,
+                            const PsdWindow_t* win, fftw_plan shared_plan, double* acc) {
+    const double complex* signal = signal_data->signal_iq;
     int nperseg = config->nperseg;
-    int noverlap = config->noverlap;
-    double fs = config->sample_rate;
-    
-    int nfft = nperseg;
-    int step = nperseg - noverlap;
-    int k_segments = (n_signal - noverlap) / step;
+    int step = nperseg - config->noverlap;
+    if (step <= 0 || signal_data->n_signal < (size_t)nperseg) return -1;
 
-    double* window = (double*)malloc(nperseg * sizeof(double));
-    generate_window(config->window_type, window, nperseg);
+    int k_segments = (int)((signal_data->n_signal - config->noverlap) / step);
+    const double* window = win->coeffs;
 
-    double u_norm = 0.0;
-    for (int i = 0; i < nperseg; i++) u_norm += window[i] * window[i];
-    u_norm /= nperseg;
+    double complex* fft_in = fftw_alloc_complex(nperseg);
+    double complex* fft_out = fftw_alloc_complex(nperseg);
+    if (!fft_in || !fft_out) {
+        fftw_free(fft_in);
+        fftw_free(fft_out);
+        return -1;
+    }
 
-    double complex* fft_in = fftw_alloc_complex(nfft);
-    double complex* fft_out = fftw_alloc_complex(nfft);
-    fftw_plan plan = fftw_plan_dft_1d(nfft, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    // A shared plan runs on our own (equally aligned) buffers
+    fftw_plan plan = shared_plan;
+    if (!plan) {
+        trace_mutex_lock(&fftw_planner_lock, "lock:fftw_planner");
+        plan = fftw_plan_dft_1d(nperseg, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+        pthread_mutex_unlock(&fftw_planner_lock);
+    }
 
-    memset(p_out, 0, nfft * sizeof(double));
+    memset(acc, 0, nperseg * sizeof(double));
 
     for (int k = 0; k < k_segments; k++) {
-        int start = k * step;
-        
+        size_t start = (size_t)k * step;
+
         for (int i = 0; i < nperseg; i++) {
             fft_in[i] = signal[start + i] * window[i];
         }
 
-        fftw_execute(plan);
+        fftw_execute_dft(plan, fft_in, fft_out);
 
-        for (int i = 0; i < nfft; i++) {
-            double mag = cabs(fft_out[i]);
-            p_out[i] += (mag * mag);
+        for (int i = 0; i < nperseg; i++) {
+            double re = creal(fft_out[i]);
+            double im = cimag(fft_out[i]);
+            acc[i] += re * re + im * im;
         }
     }
 
-    double scale = 1.0 / (fs * u_norm * k_segments * nperseg);
-    for (int i = 0; i < nfft; i++) p_out[i] *= scale;
+    if (!shared_plan) {
+        trace_mutex_lock(&fftw_planner_lock, "lock:fftw_planner");
+        fftw_destroy_plan(plan);
+        pthread_mutex_unlock(&fftw_planner_lock);
+    }
+    fftw_free(fft_in);
+    fftw_free(fft_out);
+    return k_segments;
+}
 
-    fftshift(p_out, nfft);
+/**
+ * @brief Single output pass: fftshift + density scaling + unit conversion.
+ * Bin i of the accumulator lands on (i + n/2) % n, so p_out runs from
+ * -floor(n/2)*df up to the highest positive frequency.
+ */
+static void psd_output_stage(const double* acc, int n, double scale, PsdUnit_t unit,
+                             bool exact, double* p_out) {
+    int half = n / 2;
+    int upper = n - half;   // Bins 0..upper-1 are DC and positive frequencies
+
+    psd_scale_kernel(acc, scale, unit, exact, p_out + half, upper);
+    psd_scale_kernel(acc + upper, scale, unit, exact, p_out, half);
+}
+
+/**
+ * @brief Welch on signal_data at config->sample_rate. shared_win/shared_plan
+ * come from a PsdPlan_t; when NULL they are acquired for this call only.
+ */
+static int welch_core(const signal_iq_t* signal_data, const PsdConfig_t* config, PsdUnit_t unit,
+                      const PsdWindow_t* shared_win, fftw_plan shared_plan,
+                      double f_offset, PsdAxis_t* axis, double* f_out, double* p_out) {
+    int nperseg = config->nperseg;
+    double fs = config->sample_rate;
 
-    double df = fs / nfft;
-    for (int i = 0; i < nfft; i++) {
-        f_out[i] = -fs / 2.0 + i * df;
+    const PsdWindow_t* win = shared_win ? shared_win
+                           : psd_window_acquire(config->window_type, nperseg, config->window_param);
+    if (!win) return -1;
+
+    uint64_t t0 = psd_clock_ns();
+    trace_begin("welch_accumulate");
+    double* acc = fftw_alloc_real(nperseg);
+    int k_segments = acc ? welch_accumulate(signal_data, config, win, shared_plan, acc) : -1;
+    trace_end("welch_accumulate");
+    uint64_t t1 = psd_clock_ns();
+    last_timing.accumulate_ns += t1 - t0;
+    if (k_segments <= 0) {
+        fftw_free(acc);
+        if (!shared_win) psd_window_release(win);
+        return -1;
     }
 
-    free(window);
-    fftw_destroy_plan(plan);
-    fftw_free(fft_in);
-    fftw_free(fft_out);
+    double scale = 1.0 / (fs * win->u_norm * k_segments * nperseg);
+    trace_begin("psd_output");
+    psd_output_stage(acc, nperseg, scale, unit, config->exact_log, p_out);
+    trace_end("psd_output");
+    last_timing.output_ns = psd_clock_ns() - t1;
+
+    double df = fs / nperseg;
+    double f_start = f_offset - (nperseg / 2) * df;
+    if (axis) {
+        axis->start_hz = f_start;
+        axis->step_hz = df;
+        axis->n = nperseg;
+    }
+    if (f_out) {
+        for (int i = 0; i < nperseg; i++) f_out[i] = f_start + i * df;
+    }
+
+    fftw_free(acc);
+    if (!shared_win) psd_window_release(win);
+    return 0;
+}
+
+void execute_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out) {
+    welch_core(signal_data, config, PSD_UNIT_DENSITY, NULL, NULL, 0.0, NULL, f_out, p_out);
+}
+
+// ----------------------------------------------------------------------
+// Digital Down-Conversion (NCO + cascaded polyphase decimator)
+// ----------------------------------------------------------------------
+
+#define DDC_CHUNK          16384   // Input samples pushed through the cascade per block
+#define DDC_MAX_STAGES     16
+#define DDC_MAX_FILTERS    32
+#define DDC_USABLE_BW      0.8     // Fraction of the output Nyquist band kept alias-free
+#define DDC_STOP_ATTEN_DB  80.0
+#define DDC_NCO_RENORM     1024    // Re-seed the NCO phasor every N samples
+
+typedef struct {
+    int factor;             // Stage decimation ratio
+    int rest;               // Decimation still applied after this stage
+    int ntaps;
+    double* taps;           // Time-reversed, so each output is a forward dot product
+    int refcount;
+} DdcFilter_t;
+
+typedef struct {
+    const DdcFilter_t* filt;
+    double complex* buf;    // [ntaps-1 history | current block]
+    int phase;              // Offset inside the new block of the next kept output
+} DdcStage_t;
+
+// Same scheme as the window cache: held entries stay, the LRU free one is reused
+static DdcFilter_t ddc_filter_cache[DDC_MAX_FILTERS];
+static unsigned long ddc_filter_clock = 0;
+static unsigned long ddc_filter_used[DDC_MAX_FILTERS];
+static pthread_mutex_t ddc_filter_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Kaiser-windowed sinc low-pass for one decimation stage.
+ * The passband edge protects only the band that survives the whole cascade,
+ * so early stages get a wide transition band and very few taps.
+ * Release with ddc_filter_release.
+ */
+static const DdcFilter_t* ddc_filter_acquire(int factor, int rest) {
+    trace_mutex_lock(&ddc_filter_lock, "lock:ddc_filter");
+    ddc_filter_clock++;
+
+    int victim = -1;
+    for (int i = 0; i < DDC_MAX_FILTERS; i++) {
+        DdcFilter_t* f = &ddc_filter_cache[i];
+        if (f->taps && f->factor == factor && f->rest == rest) {
+            f->refcount++;
+            ddc_filter_used[i] = ddc_filter_clock;
+            pthread_mutex_unlock(&ddc_filter_lock);
+            return f;
+        }
+        if (f->refcount == 0 && (victim < 0 || ddc_filter_used[i] < ddc_filter_used[victim])) {
+            victim = i;
+        }
+    }
+
+    if (victim < 0) {
+        pthread_mutex_unlock(&ddc_filter_lock);
+        fprintf(stderr, "[PSD] ERROR: DDC filter cache exhausted\n");
+        return NULL;
+    }
+
+    // Normalized to the stage input rate (cycles/sample)
+    double f_pass = 0.5 * DDC_USABLE_BW / (double)(factor * rest);
+    double f_stop = 1.0 / factor - f_pass;
+    double f_cut = 0.5 * (f_pass + f_stop);
+
+    double beta = 0.1102 * (DDC_STOP_ATTEN_DB - 8.7);
+    int ntaps = (int)ceil((DDC_STOP_ATTEN_DB - 7.95) / (14.36 * (f_stop - f_pass))) + 1;
+    if (ntaps % 2 == 0) ntaps++;
+
+    DdcFilter_t* f = &ddc_filter_cache[victim];
+    double* taps = (double*)realloc(f->taps, ntaps * sizeof(double));
+    if (!taps) {
+        pthread_mutex_unlock(&ddc_filter_lock);
+        return NULL;
+    }
+
+    double sum = 0.0;
+    int mid = ntaps / 2;
+    for (int n = 0; n < ntaps; n++) {
+        int m = n - mid;
+        double sinc = (m == 0) ? 2.0 * f_cut : sin(2.0 * M_PI * f_cut * m) / (M_PI * m);
+        double r = (double)m / mid;
+        double w = bessel_i0(beta * sqrt(1.0 - r * r)) / bessel_i0(beta);
+        taps[ntaps - 1 - n] = sinc * w;
+        sum += sinc * w;
+    }
+    for (int n = 0; n < ntaps; n++) taps[n] /= sum; // Unity DC gain
+
+    f->factor = factor;
+    f->rest = rest;
+    f->ntaps = ntaps;
+    f->taps = taps;
+    f->refcount = 1;
+    ddc_filter_used[victim] = ddc_filter_clock;
+
+    pthread_mutex_unlock(&ddc_filter_lock);
+    return f;
+}
+
+static void ddc_filter_release(const DdcFilter_t* filter) {
+    if (!filter) return;
+    trace_mutex_lock(&ddc_filter_lock, "lock:ddc_filter");
+    DdcFilter_t* f = (DdcFilter_t*)filter;
+    if (f->refcount > 0) f->refcount--;
+    pthread_mutex_unlock(&ddc_filter_lock);
+}
+
+/**
+ * @brief Splits the total ratio into stages ordered 5, 4, 3, 2 (largest first),
+ * pairing 2s into 4s to keep the cascade short.
+ * @return Number of stages, or -1 if the ratio has a prime factor above 5.
+ */
+static int ddc_factorize(int decimation, int* factors) {
+    int fives = 0, threes = 0, twos = 0;
+    while (decimation % 5 == 0) { fives++; decimation /= 5; }
+    while (decimation % 3 == 0) { threes++; decimation /= 3; }
+    while (decimation % 2 == 0) { twos++; decimation /= 2; }
+    if (decimation != 1) return -1;
+    if (fives + threes + (twos + 1) / 2 > DDC_MAX_STAGES) return -1;
+
+    int n = 0;
+    for (int i = 0; i < fives; i++) factors[n++] = 5;
+    for (int i = 0; i < twos / 2; i++) factors[n++] = 4;
+    for (int i = 0; i < threes; i++) factors[n++] = 3;
+    if (twos % 2) factors[n++] = 2;
+    return n;
+}
+
+/**
+ * @brief Pushes one block through a stage, evaluating only the kept outputs
+ * (the polyphase form: the discarded M-1 phases are never computed).
+ */
+static int ddc_stage_process(DdcStage_t* st, const double complex* in, int n_in, double complex* out) {
+    const DdcFilter_t* f = st->filt;
+    int hist = f->ntaps - 1;
+    int total = hist + n_in;
+
+    memcpy(st->buf + hist, in, n_in * sizeof(double complex));
+
+    int n_out = 0;
+    int p = hist + st->phase;
+    for (; p < total; p += f->factor) {
+        const double complex* x = st->buf + (p - hist);
+        double acc_re = 0.0, acc_im = 0.0;
+        for (int t = 0; t < f->ntaps; t++) {
+            acc_re += f->taps[t] * creal(x[t]);
+            acc_im += f->taps[t] * cimag(x[t]);
+        }
+        out[n_out++] = acc_re + acc_im * I;
+    }
+
+    memmove(st->buf, st->buf + n_in, hist * sizeof(double complex));
+    st->phase = p - total;
+    return n_out;
+}
+
+int psd_ddc_pick_decimation(double sample_rate, double span, size_t n_samples, int min_out) {
+    if (span <= 0.0 || sample_rate <= 0.0) return 1;
+
+    int limit = (int)floor(sample_rate * DDC_USABLE_BW / span);
+    for (int d = limit; d >= PSD_DDC_MIN_DECIMATION; d--) {
+        if (min_out > 0 && n_samples / d < (size_t)min_out) continue;
+        int factors[DDC_MAX_STAGES];
+        if (ddc_factorize(d, factors) > 0) return d;
+    }
+    return 1;
+}
+
+signal_iq_t* ddc_decimate(const signal_iq_t* signal_data, double fs, double offset_hz, int decimation) {
+    if (!signal_data || decimation < 1) return NULL;
+
+    int factors[DDC_MAX_STAGES];
+    int n_stages = ddc_factorize(decimation, factors);
+    if (n_stages < 0) {
+        fprintf(stderr, "[PSD] ERROR: DDC ratio %d must factor into 2, 3 and 5\n", decimation);
+        return NULL;
+    }
+
+    DdcStage_t stages[DDC_MAX_STAGES];
+    int rest = decimation;
+    int block = DDC_CHUNK;
+    for (int s = 0; s < n_stages; s++) {
+        rest /= factors[s];
+        stages[s].filt = ddc_filter_acquire(factors[s], rest);
+        stages[s].phase = 0;
+        stages[s].buf = stages[s].filt
+            ? (double complex*)calloc(stages[s].filt->ntaps - 1 + block, sizeof(double complex))
+            : NULL;
+        if (!stages[s].buf) {
+            for (int k = 0; k <= s; k++) {
+                free(stages[k].buf);
+                ddc_filter_release(stages[k].filt);
+            }
+            return NULL;
+        }
+        block = block / factors[s] + 1;
+    }
+
+    signal_iq_t* out = (signal_iq_t*)malloc(sizeof(signal_iq_t));
+    double complex* ping = (double complex*)malloc(DDC_CHUNK * sizeof(double complex));
+    double complex* pong = (double complex*)malloc(DDC_CHUNK * sizeof(double complex));
+    size_t cap = signal_data->n_signal / decimation + 2;
+    if (out) out->signal_iq = (double complex*)malloc(cap * sizeof(double complex));
+
+    if (!out || !out->signal_iq || !ping || !pong) {
+        if (out) free(out->signal_iq);
+        free(out); free(ping); free(pong);
+        for (int s = 0; s < n_stages; s++) {
+            free(stages[s].buf);
+            ddc_filter_release(stages[s].filt);
+        }
+        return NULL;
+    }
+    out->n_signal = 0;
+
+    // NCO: unit phasor rotated by -offset, re-seeded periodically to bound drift
+    double w = -2.0 * M_PI * offset_hz / fs;
+    double complex rot = cexp(I * w);
+    bool mix = (offset_hz != 0.0);
+
+    for (size_t pos = 0; pos < signal_data->n_signal; pos += DDC_CHUNK) {
+        int n = (int)((signal_data->n_signal - pos < DDC_CHUNK) ? signal_data->n_signal - pos : DDC_CHUNK);
+        const double complex* src = signal_data->signal_iq + pos;
+
+        if (mix) {
+            double complex ph = 1.0;
+            for (int i = 0; i < n; i++) {
+                if (((pos + i) % DDC_NCO_RENORM) == 0) ph = cexp(I * w * (double)(pos + i));
+                ping[i] = src[i] * ph;
+                ph *= rot;
+            }
+        } else {
+            memcpy(ping, src, n * sizeof(double complex));
+        }
+
+        double complex* a = ping;
+        double complex* b = pong;
+        for (int s = 0; s < n_stages && n > 0; s++) {
+            n = ddc_stage_process(&stages[s], a, n, b);
+            double complex* t = a; a = b; b = t;
+        }
+
+        if (out->n_signal + n > cap) n = (int)(cap - out->n_signal);
+        memcpy(out->signal_iq + out->n_signal, a, n * sizeof(double complex));
+        out->n_signal += n;
+    }
+
+    free(ping);
+    free(pong);
+    for (int s = 0; s < n_stages; s++) {
+        free(stages[s].buf);
+        ddc_filter_release(stages[s].filt);
+    }
+    return out;
+}
+
+static int welch_dispatch(signal_iq_t* signal_data, const PsdConfig_t* config, PsdUnit_t unit,
+                          const PsdWindow_t* win, fftw_plan plan,
+                          PsdAxis_t* axis, double* f_out, double* p_out) {
+    memset(&last_timing, 0, sizeof(last_timing));
+
+    if (config->decimation <= 1 && config->nco_offset_hz == 0.0) {
+        return welch_core(signal_data, config, unit, win, plan, 0.0, axis, f_out, p_out);
+    }
+
+    int decimation = (config->decimation > 1) ? config->decimation : 1;
+    uint64_t t_ddc = psd_clock_ns();
+    trace_begin("ddc");
+    signal_iq_t* narrow = ddc_decimate(signal_data, config->sample_rate,
+                                       config->nco_offset_hz, decimation);
+    trace_end("ddc");
+    if (!narrow) return -1;
+    last_timing.ddc_ns = psd_clock_ns() - t_ddc;
+
+    if (narrow->n_signal < (size_t)config->nperseg) {
+        fprintf(stderr, "[PSD] ERROR: DDC output (%zu) shorter than nperseg (%d)\n",
+                narrow->n_signal, config->nperseg);
+        free_signal_iq(narrow);
+        return -1;
+    }
+
+    PsdConfig_t narrow_cfg = *config;
+    narrow_cfg.sample_rate = config->sample_rate / decimation;
+    narrow_cfg.decimation = 1;
+    narrow_cfg.nco_offset_hz = 0.0;
+
+    // Axis relative to the tuned center, so callers keep adding center_freq
+    int rc = welch_core(narrow, &narrow_cfg, unit, win, plan, config->nco_offset_hz, axis, f_out, p_out);
+
+    free_signal_iq(narrow);
+    return rc;
+}
+
+int execute_welch_psd_out(signal_iq_t* signal_data, const PsdConfig_t* config, PsdUnit_t unit,
+                          PsdAxis_t* axis, double* f_out, double* p_out) {
+    return welch_dispatch(signal_data, config, unit, NULL, NULL, axis, f_out, p_out);
+}
+
+int execute_ddc_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out) {
+    return execute_welch_psd_out(signal_data, config, PSD_UNIT_DENSITY, NULL, f_out, p_out);
+}
+
+// ----------------------------------------------------------------------
+// Immutable config snapshots (derived config + window + FFTW plan)
+// ----------------------------------------------------------------------
+
+// Plans up to this size are tuned with FFTW_MEASURE (off the hot path);
+// larger ones would take seconds to measure and use FFTW_ESTIMATE.
+#define PSD_PLAN_MEASURE_MAX 65536
+
+struct PsdPlan {
+    PsdConfig_t cfg;
+    const PsdWindow_t* win;
+    fftw_plan plan;
+    atomic_int refcount;
+};
+
+// Last snapshot built; the slot owns one reference
+static _Atomic(PsdPlan_t*) plan_slot = NULL;
+
+static bool plan_config_equal(const PsdConfig_t* a, const PsdConfig_t* b) {
+    return a->window_type == b->window_type && a->window_param == b->window_param &&
+           a->sample_rate == b->sample_rate && a->nperseg == b->nperseg &&
+           a->noverlap == b->noverlap && a->decimation == b->decimation &&
+           a->nco_offset_hz == b->nco_offset_hz && a->rbw_actual == b->rbw_actual &&
+           a->exact_log == b->exact_log;
+}
+
+static PsdPlan_t* psd_plan_create(const PsdConfig_t* config) {
+    if (!config || config->nperseg <= 0) return NULL;
+
+    PsdPlan_t* p = (PsdPlan_t*)calloc(1, sizeof(PsdPlan_t));
+    if (!p) return NULL;
+    p->cfg = *config;
+    atomic_init(&p->refcount, 1);
+
+    p->win = psd_window_acquire(config->window_type, config->nperseg, config->window_param);
+    double complex* in = fftw_alloc_complex(config->nperseg);
+    double complex* out = fftw_alloc_complex(config->nperseg);
+    if (p->win && in && out) {
+        unsigned flags = (config->nperseg <= PSD_PLAN_MEASURE_MAX) ? FFTW_MEASURE : FFTW_ESTIMATE;
+        trace_mutex_lock(&fftw_planner_lock, "lock:fftw_planner");
+        p->plan = fftw_plan_dft_1d(config->nperseg, in, out, FFTW_FORWARD, flags);
+        pthread_mutex_unlock(&fftw_planner_lock);
+    }
+    fftw_free(in);
+    fftw_free(out);
+
+    if (!p->plan) {
+        fprintf(stderr, "[PSD] ERROR: could not build plan for nperseg %d\n", config->nperseg);
+        if (p->win) psd_window_release(p->win);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+PsdPlan_t* psd_plan_retain(PsdPlan_t* plan) {
+    if (plan) atomic_fetch_add_explicit(&plan->refcount, 1, memory_order_relaxed);
+    return plan;
+}
+
+void psd_plan_release(PsdPlan_t* plan) {
+    if (!plan) return;
+    if (atomic_fetch_sub_explicit(&plan->refcount, 1, memory_order_acq_rel) != 1) return;
+
+    trace_mutex_lock(&fftw_planner_lock, "lock:fftw_planner");
+    fftw_destroy_plan(plan->plan);
+    pthread_mutex_unlock(&fftw_planner_lock);
+    psd_window_release(plan->win);
+    free(plan);
+}
+
+PsdPlan_t* psd_plan_get(const PsdConfig_t* config) {
+    if (!config) return NULL;
+
+    // Take the slot's reference so nobody can free it under us
+    PsdPlan_t* cur = atomic_exchange(&plan_slot, NULL);
+    PsdPlan_t* result = NULL;
+
+    if (cur && plan_config_equal(&cur->cfg, config)) {
+        result = cur;
+    } else {
+        psd_plan_release(cur);
+        result = psd_plan_create(config);
+        if (!result) return NULL;
+    }
+
+    // Hand one reference back to the slot, one to the caller
+    psd_plan_retain(result);
+    PsdPlan_t* prev = atomic_exchange(&plan_slot, result);
+    psd_plan_release(prev);
+    return result;
+}
+
+const PsdConfig_t* psd_plan_config(const PsdPlan_t* plan) {
+    return plan ? &plan->cfg : NULL;
+}
+
+int execute_welch_psd_plan(signal_iq_t* signal_data, const PsdPlan_t* plan, PsdUnit_t unit,
+                           PsdAxis_t* axis, double* f_out, double* p_out) {
+    if (!plan) return -1;
+    return welch_dispatch(signal_data, &plan->cfg, unit, plan->win, plan->plan, axis, f_out, p_out);
 }
\ No newline at end of file
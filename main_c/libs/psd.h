@@ -8,12 +8,121 @@
 #include "datatypes.h"
 #include <stdint.h>
 #include <cjson/cJSON.h>
+
+// Below this ratio the DDC costs more than the full-band FFT it replaces
+#define PSD_DDC_MIN_DECIMATION 4
+
 static PsdWindowType_t get_window_type_from_string(const char *window_str);
 signal_iq_t* load_iq_from_buffer(const int8_t* buffer, size_t buffer_size);
 void free_signal_iq(signal_iq_t* signal);
 void execute_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out);
+
+/**
+ * @brief Largest 2/3/5-smooth decimation that still keeps `span` inside the
+ * alias-free part of the decimated band and leaves at least `min_out` of the
+ * `n_samples` input samples after decimation (min_out <= 0: no limit).
+ * Returns 1 when the DDC is not worth it.
+ */
+int psd_ddc_pick_decimation(double sample_rate, double span, size_t n_samples, int min_out);
+
+/**
+ * @brief NCO mix by -offset_hz followed by a cascaded polyphase FIR decimator.
+ * Filter taps are designed once per stage ratio and kept in a small LRU cache.
+ * @return New signal at fs/decimation (free with free_signal_iq), or NULL.
+ */
+signal_iq_t* ddc_decimate(const signal_iq_t* signal_data, double fs, double offset_hz, int decimation);
+
+/**
+ * @brief Welch PSD on the down-converted stream described by config->decimation
+ * and config->nco_offset_hz. config->nperseg refers to the decimated rate.
+ * f_out is relative to the tuned center (offset included).
+ * @return 0 on success, -1 on failure.
+ */
+int execute_ddc_welch_psd(signal_iq_t* signal_data, const PsdConfig_t* config, double* f_out, double* p_out);
+/**
+ * @brief Cached window coefficients with their normalizations.
+ * Entries are shared; hold one with psd_window_acquire and give it back
+ * with psd_window_release. Held entries are never evicted.
+ */
+typedef struct {
+    PsdWindowType_t type;
+    int length;
+    double param;       // Kaiser beta / Tukey alpha (defaults resolved)
+    double* coeffs;
+    double u_norm;      // sum(w^2) / N
+    double enbw;        // N * sum(w^2) / sum(w)^2, in bins
+    int refcount;
+} PsdWindow_t;
+
+const PsdWindow_t* psd_window_acquire(PsdWindowType_t type, int length, double param);
+void psd_window_release(const PsdWindow_t* window);
+
+/**
+ * @brief Numerical ENBW (in bins) of a window; param <= 0 selects the default
+ * shape (Kaiser beta 8.6, Tukey alpha 0.5).
+ */
+double psd_window_enbw(PsdWindowType_t type, double param);
 double get_window_enbw_factor(PsdWindowType_t type); 
+
+/**
+ * @brief Smallest n' >= n whose only prime factors are 2, 3, 5 and 7
+ * (sizes FFTW's codelets handle without a generic-radix pass).
+ */
+int psd_next_smooth_size(int n);
 int scale_psd(double* psd, int nperseg, const char* scale_str);
+
+/**
+ * @brief Maps a config scale string ("dBm", "dBuV", "dBmV", "W", "V") to
+ * its unit. NULL or unknown strings give dBm, matching scale_psd.
+ */
+PsdUnit_t psd_parse_unit(const char* scale_str);
+
+/**
+ * @brief Welch PSD (with the DDC stage when config asks for it) whose output
+ * stage writes shifted, scaled, unit-converted bins straight from the
+ * accumulator in one pass.
+ * @param unit  PSD_UNIT_DENSITY keeps V^2/Hz; other units match scale_psd.
+ *              dB units use a fast log10 (<= 6e-6 dB error) unless
+ *              config->exact_log is set.
+ * @param axis  Optional start/step description of the frequency axis.
+ * @param f_out Optional materialised axis (NULL to skip).
+ * @return 0 on success, -1 on failure.
+ */
+int execute_welch_psd_out(signal_iq_t* signal_data, const PsdConfig_t* config, PsdUnit_t unit,
+                          PsdAxis_t* axis, double* f_out, double* p_out);
+
+/** Wall time spent in each stage of the last Welch call on this thread */
+typedef struct {
+    uint64_t ddc_ns;            // NCO + decimator (0 without DDC)
+    uint64_t accumulate_ns;     // Windowed FFT loop
+    uint64_t output_ns;         // Shift + scaling + unit conversion
+} PsdTiming_t;
+
+void psd_last_timing(PsdTiming_t* out);
+/**
+ * @brief Immutable, reference-counted snapshot of a derived config with its
+ * window and FFTW plan. Built once (planning happens off the acquisition
+ * path) and shared by every cycle that uses the same config.
+ */
+typedef struct PsdPlan PsdPlan_t;
+
+/**
+ * @brief Returns a retained snapshot for config, reusing the last one built
+ * when the config matches (lock-free slot, atomic exchange). Safe from any
+ * thread. Release with psd_plan_release.
+ */
+PsdPlan_t* psd_plan_get(const PsdConfig_t* config);
+PsdPlan_t* psd_plan_retain(PsdPlan_t* plan);
+void psd_plan_release(PsdPlan_t* plan);
+const PsdConfig_t* psd_plan_config(const PsdPlan_t* plan);
+
+/**
+ * @brief execute_welch_psd_out using the snapshot's config, window and plan.
+ */
+int execute_welch_psd_plan(signal_iq_t* signal_data, const PsdPlan_t* plan, PsdUnit_t unit,
+                           PsdAxis_t* axis, double* f_out, double* p_out);
+
 int parse_psd_config(const char *json_string, DesiredCfg_t *target);
+int parse_psd_batch(const char *json_string, DesiredCfg_t **targets);
 void free_desired_psd(DesiredCfg_t *target);
 #endif
\ No newline at end of file
@@ -0,0 +1,126 @@
+/**
+ * @file Modules/psd_shm.c
+ */
+
+#define _GNU_SOURCE
+
+#include "psd_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(PsdShmRingHeader_t) <= PSD_SHM_RING_HDR, "ring header too large");
+_Static_assert(sizeof(PsdShmSlotHeader_t) == PSD_SHM_SLOT_HDR, "slot header layout");
+
+static PsdShmSlotHeader_t* slot_at(psd_shm_t *shm, uint32_t idx) {
+    return (PsdShmSlotHeader_t*)(shm->base + PSD_SHM_RING_HDR + (size_t)idx * shm->hdr->slot_stride);
+}
+
+psd_shm_t* psd_shm_create(int n_slots, int max_bins) {
+    if (n_slots <= 0) n_slots = PSD_SHM_SLOTS;
+    if (max_bins <= 0) max_bins = PSD_SHM_MAX_BINS;
+
+    // Keep each slot's bins 64-byte aligned
+    size_t stride = PSD_SHM_SLOT_HDR + (size_t)max_bins * sizeof(float);
+    stride = (stride + 63) & ~(size_t)63;
+    size_t size = PSD_SHM_RING_HDR + (size_t)n_slots * stride;
+
+    // Start from a fresh object so stale readers of an old layout fail the magic check
+    shm_unlink(PSD_SHM_NAME);
+    int fd = shm_open(PSD_SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "[SHM] Error: shm_open(%s) failed\n", PSD_SHM_NAME);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        fprintf(stderr, "[SHM] Error: could not size %s to %zu bytes\n", PSD_SHM_NAME, size);
+        close(fd);
+        shm_unlink(PSD_SHM_NAME);
+        return NULL;
+    }
+
+    uint8_t *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "[SHM] Error: mmap of %zu bytes failed\n", size);
+        shm_unlink(PSD_SHM_NAME);
+        return NULL;
+    }
+
+    psd_shm_t *shm = malloc(sizeof(psd_shm_t));
+    if (!shm) {
+        munmap(base, size);
+        shm_unlink(PSD_SHM_NAME);
+        return NULL;
+    }
+    shm->base = base;
+    shm->size = size;
+    shm->hdr = (PsdShmRingHeader_t*)base;
+
+    // ftruncate zero-fills: every seqlock starts at 0 (even, empty)
+    shm->hdr->version = PSD_SHM_VERSION;
+    shm->hdr->header_len = PSD_SHM_RING_HDR;
+    shm->hdr->n_slots = (uint32_t)n_slots;
+    shm->hdr->max_bins = (uint32_t)max_bins;
+    shm->hdr->slot_stride = (uint32_t)stride;
+    atomic_store_explicit(&shm->hdr->frames, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(shm->hdr->magic, PSD_SHM_MAGIC, 4);   // Last: readers check it first
+
+    printf("[SHM] Result ring %s: %d slots x %d bins (%zu bytes)\n",
+           PSD_SHM_NAME, n_slots, max_bins, size);
+    return shm;
+}
+
+int psd_shm_write(psd_shm_t *shm, const PsdShmMeta_t *meta, const double *psd, int bins,
+                  uint64_t *frame_out) {
+    if (!shm || !meta || !psd || bins <= 0) return -1;
+    if ((uint32_t)bins > shm->hdr->max_bins) {
+        fprintf(stderr, "[SHM] Error: %d bins exceed slot capacity %u\n", bins, shm->hdr->max_bins);
+        return -1;
+    }
+
+    uint64_t frame = atomic_load_explicit(&shm->hdr->frames, memory_order_relaxed);
+    uint32_t idx = (uint32_t)(frame % shm->hdr->n_slots);
+    PsdShmSlotHeader_t *slot = slot_at(shm, idx);
+    float *data = (float*)((uint8_t*)slot + PSD_SHM_SLOT_HDR);
+
+    // 1. Seqlock odd: readers that overlap the write will see it change
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    // 2. Payload
+    slot->start_hz = meta->start_hz;
+    slot->step_hz = meta->step_hz;
+    slot->bins = (uint32_t)bins;
+    slot->units = meta->units;
+    slot->timestamp_ns = meta->timestamp_ns;
+    slot->config_hash = meta->config_hash;
+    slot->frame = frame;
+    memset(slot->request_id, 0, PSD_SHM_ID_LEN);
+    if (meta->request_id) strncpy(slot->request_id, meta->request_id, PSD_SHM_ID_LEN - 1);
+    for (int i = 0; i < bins; i++) data[i] = (float)psd[i];
+
+    // 3. Seqlock even again, then advance the ring
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+    atomic_store_explicit(&shm->hdr->frames, frame + 1, memory_order_release);
+    if (frame_out) *frame_out = frame;
+    return (int)idx;
+}
+
+void psd_shm_pack_notify(int slot, uint64_t frame, uint8_t out[PSD_SHM_NOTIFY_LEN]) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)((uint32_t)slot >> (8 * i));
+    for (int i = 0; i < 8; i++) out[4 + i] = (uint8_t)(frame >> (8 * i));
+}
+
+void psd_shm_destroy(psd_shm_t *shm) {
+    if (!shm) return;
+    munmap(shm->base, shm->size);
+    shm_unlink(PSD_SHM_NAME);
+    free(shm);
+}
@@ -0,0 +1,120 @@
+/**
+ * @file Modules/psd_shm.h
+ * @brief POSIX shared-memory ring of PSD results for consumers on the same host
+ *
+ * Layout of PSD_SHM_NAME (native little-endian, mapped read-only by readers):
+ *   ring header (PSD_SHM_RING_HDR bytes), then n_slots slots of slot_stride bytes.
+ *
+ * Ring header:
+ *   0  char[4] magic "PSDR"
+ *   4  u16     version
+ *   6  u16     ring header length
+ *   8  u32     n_slots
+ *  12  u32     max_bins
+ *  16  u32     slot stride [bytes]
+ *  24  u64     frames written (next frame number)
+ *
+ * Slot (header PSD_SHM_SLOT_HDR bytes, then max_bins float32):
+ *   0  u64     seqlock: odd while the writer is inside the slot
+ *   8  f64     start frequency [Hz, absolute]
+ *  16  f64     bin step [Hz]
+ *  24  u32     bins
+ *  28  u8      units (PsdUnit_t)
+ *  32  u64     timestamp [ns since epoch]
+ *  40  u64     config hash
+ *  48  u64     frame number
+ *  64  char[64] request id (NUL terminated, may be empty)
+ *
+ * A reader copies (or uses) the slot and then re-reads the seqlock: if it
+ * changed or was odd, the read was torn and must be discarded. After each
+ * write the slot is announced on PSD_SHM_TOPIC as one PSD_SHM_NOTIFY_LEN
+ * frame: u32 slot index, u64 frame number. A reader whose slot holds an
+ * older frame than announced is mapping a ring the writer has since
+ * re-created (psd_shm_create unlinks the old one) and must re-open it.
+ */
+
+#ifndef PSD_SHM_H
+#define PSD_SHM_H
+
+#include "datatypes.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define PSD_SHM_NAME        "/psd_results"
+#define PSD_SHM_TOPIC       "psd_shm"
+#define PSD_SHM_MAGIC       "PSDR"
+#define PSD_SHM_VERSION     1
+#define PSD_SHM_RING_HDR    64
+#define PSD_SHM_SLOT_HDR    128
+#define PSD_SHM_SLOTS       8
+#define PSD_SHM_MAX_BINS    262144
+#define PSD_SHM_ID_LEN      64
+#define PSD_SHM_NOTIFY_LEN  12      // u32 slot + u64 frame
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_len;
+    uint32_t n_slots;
+    uint32_t max_bins;
+    uint32_t slot_stride;
+    uint32_t reserved;
+    _Atomic uint64_t frames;
+} PsdShmRingHeader_t;
+
+typedef struct {
+    _Atomic uint64_t seq;
+    double start_hz;
+    double step_hz;
+    uint32_t bins;
+    uint8_t units;
+    uint8_t pad[3];
+    uint64_t timestamp_ns;
+    uint64_t config_hash;
+    uint64_t frame;
+    uint8_t reserved[8];
+    char request_id[PSD_SHM_ID_LEN];
+} PsdShmSlotHeader_t;
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    PsdShmRingHeader_t *hdr;
+} psd_shm_t;
+
+/** Metadata of one published trace (bins come separately) */
+typedef struct {
+    double start_hz;
+    double step_hz;
+    uint8_t units;
+    uint64_t timestamp_ns;
+    uint64_t config_hash;
+    const char *request_id;
+} PsdShmMeta_t;
+
+/**
+ * @brief Creates (or re-creates) the shared ring. 0 selects the defaults.
+ * @return Ring handle or NULL on error.
+ */
+psd_shm_t* psd_shm_create(int n_slots, int max_bins);
+
+/**
+ * @brief Writes one trace into the next slot under its seqlock.
+ * @param frame_out Optional: frame number stored in the slot.
+ * @return Slot index written, or -1 (e.g. more bins than max_bins).
+ */
+int psd_shm_write(psd_shm_t *shm, const PsdShmMeta_t *meta, const double *psd, int bins,
+                  uint64_t *frame_out);
+
+/**
+ * @brief Packs the PSD_SHM_TOPIC notification for a written slot.
+ */
+void psd_shm_pack_notify(int slot, uint64_t frame, uint8_t out[PSD_SHM_NOTIFY_LEN]);
+
+/**
+ * @brief Unmaps and unlinks the ring.
+ */
+void psd_shm_destroy(psd_shm_t *shm);
+
+#endif
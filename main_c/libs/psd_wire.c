@@ -0,0 +1,314 @@
+/**
+ * @file Modules/psd_wire.c
+ */
+
+#include "psd_wire.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+#define RICE_ESCAPE     24      // Quotients >= this are sent raw
+#define RICE_RAW_BITS   17      // Enough for any zigzag int16 difference
+#define RICE_MAX_K      16
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_f64(uint8_t *p, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u64(p, bits);
+}
+
+uint64_t psd_config_hash(const DesiredCfg_t *cfg) {
+    uint64_t h = FNV_OFFSET;
+    if (!cfg) return h;
+
+    // Field by field: struct padding must not leak into the hash
+    h = fnv1a(h, &cfg->center_freq, sizeof(cfg->center_freq));
+    h = fnv1a(h, &cfg->sample_rate, sizeof(cfg->sample_rate));
+    h = fnv1a(h, &cfg->span, sizeof(cfg->span));
+    h = fnv1a(h, &cfg->rbw, sizeof(cfg->rbw));
+    h = fnv1a(h, &cfg->overlap, sizeof(cfg->overlap));
+    h = fnv1a(h, &cfg->window_type, sizeof(cfg->window_type));
+    h = fnv1a(h, &cfg->window_param, sizeof(cfg->window_param));
+    h = fnv1a(h, &cfg->nco_offset_hz, sizeof(cfg->nco_offset_hz));
+    h = fnv1a(h, &cfg->fft_sizing, sizeof(cfg->fft_sizing));
+    h = fnv1a(h, &cfg->lna_gain, sizeof(cfg->lna_gain));
+    h = fnv1a(h, &cfg->vga_gain, sizeof(cfg->vga_gain));
+    uint8_t amp = cfg->amp_enabled ? 1 : 0;
+    h = fnv1a(h, &amp, 1);
+    const char *scale = cfg->scale ? cfg->scale : "dBm";
+    h = fnv1a(h, scale, strlen(scale));
+    return h;
+}
+
+size_t psd_wire_pack_header(const PsdWireHeader_t *hdr, uint8_t *out) {
+    size_t id_len = hdr->request_id ? strlen(hdr->request_id) : 0;
+    if (id_len > 255) id_len = 255;
+    size_t total = PSD_WIRE_HEADER_LEN + (id_len ? 1 + id_len : 0);
+
+    memset(out, 0, PSD_WIRE_HEADER_LEN);
+    memcpy(out, PSD_WIRE_MAGIC, 4);
+    put_u16(out + 4, PSD_WIRE_VERSION);
+    put_u16(out + 6, (uint16_t)total);
+    put_f64(out + 8, hdr->start_hz);
+    put_f64(out + 16, hdr->step_hz);
+    put_u32(out + 24, hdr->bins);
+    out[28] = hdr->units;
+    out[29] = hdr->encoding;
+    put_u16(out + 30, hdr->flags);
+    put_u64(out + 32, hdr->timestamp_ns);
+    put_u64(out + 40, hdr->config_hash);
+
+    if (id_len) {
+        out[PSD_WIRE_HEADER_LEN] = (uint8_t)id_len;
+        memcpy(out + PSD_WIRE_HEADER_LEN + 1, hdr->request_id, id_len);
+    }
+    return total;
+}
+
+void psd_wire_pack_f32(const double *psd, size_t n, uint8_t *out) {
+    for (size_t i = 0; i < n; i++) {
+        float v = (float)psd[i];
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        put_u32(out + 4 * i, bits);
+    }
+}
+
+// =========================================================
+// QUANTIZED + DELTA ENCODING
+// =========================================================
+
+typedef struct {
+    uint8_t *p;
+    size_t bit;
+} BitWriter_t;
+
+static void bw_put(BitWriter_t *bw, uint32_t value, int nbits) {
+    for (int b = nbits - 1; b >= 0; b--) {
+        if ((value >> b) & 1u) bw->p[bw->bit >> 3] |= (uint8_t)(0x80u >> (bw->bit & 7));
+        bw->bit++;
+    }
+}
+
+static void bw_rice(BitWriter_t *bw, uint32_t u, int k) {
+    uint32_t q = u >> k;
+    if (q >= RICE_ESCAPE) {
+        bw_put(bw, (1u << RICE_ESCAPE) - 1u, RICE_ESCAPE);
+        bw_put(bw, u, RICE_RAW_BITS);
+        return;
+    }
+    // Unary quotient: q ones then a zero (buffer is pre-zeroed)
+    if (q) bw_put(bw, (1u << q) - 1u, (int)q);
+    bw->bit++;
+    if (k) bw_put(bw, u & ((1u << k) - 1u), k);
+}
+
+static inline uint32_t zigzag(int32_t r) {
+    return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+static bool unit_is_db(uint8_t units) {
+    return units == PSD_UNIT_DBM || units == PSD_UNIT_DBUV || units == PSD_UNIT_DBMV;
+}
+
+static void encoder_reset(PsdWireEncoder_t *enc) {
+    free(enc->prev);
+    enc->prev = NULL;
+    enc->n = 0;
+    enc->since_keyframe = 0;
+}
+
+void psd_wire_encoder_config(PsdWireEncoder_t *enc, PsdWireEncoding_t encoding,
+                             double step_db, int keyframe_interval) {
+    if (!enc) return;
+    if (step_db <= 0.0) {
+        step_db = (encoding == PSD_WIRE_Q8) ? PSD_WIRE_Q8_DEFAULT_STEP : PSD_WIRE_Q16_DEFAULT_STEP;
+    }
+    if (keyframe_interval <= 0) keyframe_interval = PSD_WIRE_DEFAULT_KEYFRAME;
+
+    if (enc->encoding != encoding || enc->step_db != step_db) encoder_reset(enc);
+    enc->encoding = encoding;
+    enc->step_db = step_db;
+    enc->keyframe_interval = keyframe_interval;
+}
+
+static const uint8_t* encode_f32(PsdWireEncoder_t *enc, PsdWireHeader_t *hdr,
+                                 const double *psd, size_t n, size_t *out_len) {
+    hdr->encoding = PSD_WIRE_F32;
+    hdr->flags = PSD_WIRE_FLAG_KEYFRAME;
+    psd_wire_pack_f32(psd, n, enc->buf);
+    *out_len = n * sizeof(float);
+    return enc->buf;
+}
+
+const uint8_t* psd_wire_encode(PsdWireEncoder_t *enc, PsdWireHeader_t *hdr,
+                               const double *psd, size_t n, size_t *out_len) {
+    if (!enc || !hdr || !psd || !out_len || n == 0) return NULL;
+
+    // Worst case: every residual escaped
+    size_t need = PSD_WIRE_Q_HEADER_LEN + (n * (RICE_ESCAPE + RICE_RAW_BITS) + 7) / 8;
+    if (need < n * sizeof(float)) need = n * sizeof(float);
+    if (enc->buf_cap < need) {
+        uint8_t *nb = realloc(enc->buf, need);
+        if (!nb) {
+            fprintf(stderr, "[PSD] ERROR: wire buffer allocation failed\n");
+            return NULL;
+        }
+        enc->buf = nb;
+        enc->buf_cap = need;
+    }
+
+    if (enc->encoding == PSD_WIRE_F32 || !unit_is_db(hdr->units)) {
+        return encode_f32(enc, hdr, psd, n, out_len);
+    }
+
+    // 1. Keyframe decision: no reference, new config/size, or interval reached
+    bool key = (enc->prev == NULL) || (enc->n != n) || (enc->last_hash != hdr->config_hash) ||
+               (enc->since_keyframe >= enc->keyframe_interval);
+    if (key) {
+        free(enc->prev);
+        enc->prev = calloc(n, sizeof(int32_t));
+        if (!enc->prev) {
+            enc->n = 0;
+            return encode_f32(enc, hdr, psd, n, out_len);
+        }
+        enc->n = n;
+        enc->since_keyframe = 0;
+        enc->last_hash = hdr->config_hash;
+    }
+
+    // Quantize with the step and base as sent (float32), so the decoder's
+    // base + code * step is within step / 2 of the input
+    double step = (double)(float)enc->step_db;
+    int32_t lo = -32768, hi = 32767;
+    if (enc->encoding == PSD_WIRE_Q8) {
+        lo = 0;
+        hi = 255;
+        // Q8 codes are offsets from the keyframe's minimum, kept for its deltas
+        if (key) {
+            double mn = INFINITY;
+            for (size_t i = 0; i < n; i++) if (psd[i] < mn) mn = psd[i];
+            float base = isfinite(mn) ? (float)(floor(mn / step) * step) : 0.0f;
+            if (base > mn) base = nextafterf(base, -INFINITY);   // Keep every bin >= base
+            enc->base_db = base;
+        }
+    } else {
+        enc->base_db = 0.0;
+    }
+
+    // 2. Quantize, form residuals and keep the codes as the next reference
+    uint16_t flags = key ? PSD_WIRE_FLAG_KEYFRAME : 0;
+    uint64_t sum = 0;
+    int32_t left = 0;
+    uint32_t *zz = malloc(n * sizeof(uint32_t));
+    if (!zz) return encode_f32(enc, hdr, psd, n, out_len);
+
+    for (size_t i = 0; i < n; i++) {
+        double q = (psd[i] - enc->base_db) / step;
+        int32_t c;
+        if (!(q >= lo)) { c = lo; flags |= PSD_WIRE_FLAG_CLIPPED; }   // Also catches NaN
+        else if (q > hi) { c = hi; flags |= PSD_WIRE_FLAG_CLIPPED; }
+        else c = (int32_t)lround(q);
+
+        int32_t ref = key ? left : enc->prev[i];
+        zz[i] = zigzag(c - ref);
+        sum += zz[i];
+        left = c;
+        enc->prev[i] = c;
+    }
+
+    // 3. Rice parameter from the mean residual magnitude
+    int k = 0;
+    while (k < RICE_MAX_K && (sum >> (k + 1)) >= n) k++;
+
+    uint8_t *out = enc->buf;
+    memset(out, 0, need);
+    float f;
+    uint32_t bits;
+    f = (float)step;         memcpy(&bits, &f, 4); put_u32(out + 0, bits);
+    f = (float)enc->base_db; memcpy(&bits, &f, 4); put_u32(out + 4, bits);
+    put_u32(out + 8, enc->seq);
+    out[12] = (uint8_t)k;
+
+    BitWriter_t bw = { out + PSD_WIRE_Q_HEADER_LEN, 0 };
+    for (size_t i = 0; i < n; i++) bw_rice(&bw, zz[i], k);
+    free(zz);
+
+    enc->seq++;
+    enc->since_keyframe++;
+
+    hdr->encoding = (uint8_t)enc->encoding;
+    hdr->flags = flags;
+    *out_len = PSD_WIRE_Q_HEADER_LEN + (bw.bit + 7) / 8;
+    return out;
+}
+
+uint8_t* psd_wire_take_payload(PsdWireEncoder_t *enc) {
+    if (!enc) return NULL;
+    uint8_t *p = enc->buf;
+    enc->buf = NULL;
+    enc->buf_cap = 0;
+    return p;
+}
+
+void psd_wire_encoder_free(PsdWireEncoder_t *enc) {
+    if (!enc) return;
+    encoder_reset(enc);
+    free(enc->buf);
+    enc->buf = NULL;
+    enc->buf_cap = 0;
+}
+
+PsdWireEncoder_t* psd_wire_encoder_lookup(PsdWireEncoderTable_t *table, uint64_t config_hash) {
+    if (!table) return NULL;
+    table->clock++;
+
+    int victim = 0;
+    for (int i = 0; i < PSD_WIRE_MAX_ENCODERS; i++) {
+        if (table->used[i] && table->hash[i] == config_hash) {
+            table->used[i] = table->clock;
+            return &table->enc[i];
+        }
+        if (table->used[i] < table->used[victim]) victim = i;
+    }
+
+    // Keep the payload buffer, drop the reference trace
+    encoder_reset(&table->enc[victim]);
+    table->hash[victim] = config_hash;
+    table->used[victim] = table->clock;
+    return &table->enc[victim];
+}
+
+void psd_wire_encoder_table_free(PsdWireEncoderTable_t *table) {
+    if (!table) return;
+    for (int i = 0; i < PSD_WIRE_MAX_ENCODERS; i++) {
+        psd_wire_encoder_free(&table->enc[i]);
+        table->used[i] = 0;
+    }
+}
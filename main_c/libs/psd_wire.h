@@ -0,0 +1,153 @@
+/**
+ * @file Modules/psd_wire.h
+ * @brief Versioned binary PSD result message (alternative to the JSON output)
+ *
+ * Sent as a multipart ZMQ message:
+ *   frame 0: topic (PSD_WIRE_TOPIC)
+ *   frame 1: little-endian header (PSD_WIRE_HEADER_LEN bytes + extension)
+ *   frame 2: payload, bins * float32 little-endian
+ *
+ * Header layout (offsets in bytes):
+ *   0  char[4] magic "PSDB"
+ *   4  u16     version
+ *   6  u16     header length
+ *   8  f64     start frequency [Hz, absolute]
+ *  16  f64     bin step [Hz]
+ *  24  u32     bins
+ *  28  u8      units (PsdUnit_t)
+ *  29  u8      payload encoding (PSD_WIRE_F32)
+ *  30  u16     flags (PSD_WIRE_FLAG_*)
+ *  32  u64     timestamp [ns since epoch]
+ *  40  u64     config hash (psd_config_hash)
+ *  48  u8      request id length L (only if header length > 48)
+ *  49  char[L] request id, not NUL terminated
+ *
+ * Quantized encodings (Q16/Q8, dB units only) prefix the payload with:
+ *   0  f32     step [dB]; reconstruction error is at most step / 2
+ *   4  f32     base [dB]; value = base + code * step
+ *   8  u32     sequence number (a delta frame references sequence - 1)
+ *  12  u8      Rice parameter k
+ *  13  u8[3]   reserved
+ * followed by one Rice-coded zigzag residual per bin, MSB first. Residuals
+ * are code[i] - code[i-1] on keyframes and code[i] - previous_code[i] on
+ * delta frames. Quotients >= 24 are escaped: 24 ones, then 17 raw bits.
+ */
+
+#ifndef PSD_WIRE_H
+#define PSD_WIRE_H
+
+#include "datatypes.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define PSD_WIRE_TOPIC       "psd_bin"
+#define PSD_WIRE_MAGIC       "PSDB"
+#define PSD_WIRE_VERSION     1
+#define PSD_WIRE_HEADER_LEN  48
+#define PSD_WIRE_HEADER_MAX  (PSD_WIRE_HEADER_LEN + 1 + 255)
+
+#define PSD_WIRE_FLAG_KEYFRAME  0x0001  // Payload does not depend on a previous frame
+#define PSD_WIRE_FLAG_CLIPPED   0x0002  // Some bins saturated: error bound does not hold for them
+
+#define PSD_WIRE_Q_HEADER_LEN       16
+#define PSD_WIRE_Q16_DEFAULT_STEP   0.01
+#define PSD_WIRE_Q8_DEFAULT_STEP    0.5
+#define PSD_WIRE_DEFAULT_KEYFRAME   16
+#define PSD_WIRE_MAX_ENCODERS       16      // Traces kept for delta coding at once
+
+typedef struct {
+    double start_hz;
+    double step_hz;
+    uint32_t bins;
+    uint8_t units;
+    uint8_t encoding;
+    uint16_t flags;
+    uint64_t timestamp_ns;
+    uint64_t config_hash;
+    const char *request_id;     // Optional, truncated to 255 bytes
+} PsdWireHeader_t;
+
+/** Encoder state: quantization parameters plus the last frame's codes */
+typedef struct {
+    PsdWireEncoding_t encoding;
+    double step_db;
+    int keyframe_interval;
+
+    uint64_t last_hash;
+    uint32_t seq;
+    int since_keyframe;
+    double base_db;
+    int32_t *prev;          // Codes of the previous frame (NULL = none)
+    size_t n;
+    uint8_t *buf;           // Payload buffer, reused across frames
+    size_t buf_cap;
+} PsdWireEncoder_t;
+
+/**
+ * @brief One encoder per config hash, so interleaved configs (batch
+ * surveys) each keep their own reference trace. When full, the least
+ * recently used slot is reset and reused.
+ */
+typedef struct {
+    PsdWireEncoder_t enc[PSD_WIRE_MAX_ENCODERS];
+    uint64_t hash[PSD_WIRE_MAX_ENCODERS];
+    uint64_t used[PSD_WIRE_MAX_ENCODERS];    // 0 = empty slot
+    uint64_t clock;
+} PsdWireEncoderTable_t;
+
+/**
+ * @brief FNV-1a hash over the fields that define a trace (tuning, RBW,
+ * span, window, units...). Equal hashes mean traces are comparable.
+ */
+uint64_t psd_config_hash(const DesiredCfg_t *cfg);
+
+/**
+ * @brief Serializes the header into out[PSD_WIRE_HEADER_MAX].
+ * @return Bytes written (PSD_WIRE_HEADER_LEN without a request id)
+ */
+size_t psd_wire_pack_header(const PsdWireHeader_t *hdr, uint8_t *out);
+
+/**
+ * @brief Converts bins to little-endian float32 into out (4 * n bytes).
+ */
+void psd_wire_pack_f32(const double *psd, size_t n, uint8_t *out);
+
+/**
+ * @brief Sets the encoding parameters; step_db or keyframe_interval <= 0
+ * select the defaults. Resets the delta state if anything changed.
+ */
+void psd_wire_encoder_config(PsdWireEncoder_t *enc, PsdWireEncoding_t encoding,
+                             double step_db, int keyframe_interval);
+
+/**
+ * @brief Encodes one trace. Fills hdr->encoding and hdr->flags (hdr->units
+ * and hdr->config_hash must be set). Linear units always go out as F32.
+ * @return Payload (owned by the encoder, valid until the next call) or NULL
+ */
+const uint8_t* psd_wire_encode(PsdWireEncoder_t *enc, PsdWireHeader_t *hdr,
+                               const double *psd, size_t n, size_t *out_len);
+
+/**
+ * @brief Detaches the last payload from the encoder (caller frees it with
+ * free(), e.g. via zpub_free_default). The next encode allocates a new one.
+ */
+uint8_t* psd_wire_take_payload(PsdWireEncoder_t *enc);
+
+/**
+ * @brief Releases the encoder buffers.
+ */
+void psd_wire_encoder_free(PsdWireEncoder_t *enc);
+
+/**
+ * @brief Encoder holding the reference trace of config_hash. A new hash
+ * takes an empty slot or the least recently used one (its delta state is
+ * dropped, so its next frame is a keyframe).
+ */
+PsdWireEncoder_t* psd_wire_encoder_lookup(PsdWireEncoderTable_t *table, uint64_t config_hash);
+
+/**
+ * @brief Releases every encoder in the table.
+ */
+void psd_wire_encoder_table_free(PsdWireEncoderTable_t *table);
+
+#endif
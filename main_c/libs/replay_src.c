@@ -0,0 +1,121 @@
+/**
+ * @file Drivers/replay_src.c
+ */
+
+#define _GNU_SOURCE
+
+#include "replay_src.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+int8_t* replay_load_cs8(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "[REPLAY] Cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+
+    size_t usable = (size > 0) ? ((size_t)size / REPLAY_TRANSFER_BYTES) * REPLAY_TRANSFER_BYTES : 0;
+    if (usable == 0) {
+        fprintf(stderr, "[REPLAY] %s is shorter than one transfer (%d bytes)\n", path, REPLAY_TRANSFER_BYTES);
+        fclose(fp);
+        return NULL;
+    }
+
+    int8_t *data = malloc(usable);
+    if (!data || fread(data, 1, usable, fp) != usable) {
+        fprintf(stderr, "[REPLAY] Failed to read %s\n", path);
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *len = usable;
+    return data;
+}
+
+int8_t* replay_synth_cs8(size_t n_transfers, size_t *len) {
+    size_t bytes = n_transfers * REPLAY_TRANSFER_BYTES;
+    int8_t *data = malloc(bytes);
+    if (!data) return NULL;
+
+    // Tone frequencies are whole cycles per loop, so the wrap is seamless
+    size_t n = bytes / 2;
+    const double cycles[3] = { 1031.0, -4217.0, 7919.0 };
+    const double amp[3] = { 40.0, 12.0, 4.0 };
+    uint32_t rng = 0x2545F491u;
+    for (size_t i = 0; i < n; i++) {
+        double re = 0.0, im = 0.0;
+        for (int k = 0; k < 3; k++) {
+            double ph = 2.0 * M_PI * cycles[k] * (double)i / (double)n;
+            re += amp[k] * cos(ph);
+            im += amp[k] * sin(ph);
+        }
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        re += (double)((int)(rng & 0xff) - 128) / 16.0;
+        im += (double)((int)((rng >> 8) & 0xff) - 128) / 16.0;
+        data[2 * i] = (int8_t)lrint(fmax(-127.0, fmin(127.0, re)));
+        data[2 * i + 1] = (int8_t)lrint(fmax(-127.0, fmin(127.0, im)));
+    }
+    *len = bytes;
+    return data;
+}
+
+static void *pacer_main(void *arg) {
+    replay_t *r = arg;
+    // Two bytes per complex sample
+    double period_ns = (double)REPLAY_TRANSFER_BYTES / (2.0 * r->rate_sps) * 1e9;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t t0 = (uint64_t)start.tv_sec * 1000000000ull + (uint64_t)start.tv_nsec;
+
+    size_t offset = 0;
+    for (uint64_t k = 1; atomic_load_explicit(&r->running, memory_order_relaxed); k++) {
+        uint64_t deadline = t0 + (uint64_t)(k * period_ns);
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+        if (now_ns < deadline) {
+            struct timespec ts = { (time_t)(deadline / 1000000000ull), (long)(deadline % 1000000000ull) };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        } else if (k > 1) {
+            atomic_fetch_add_explicit(&r->late, 1, memory_order_relaxed);
+        }
+
+        if (r->sink((const uint8_t*)r->data + offset, REPLAY_TRANSFER_BYTES, r->ctx) != 0) break;
+        atomic_fetch_add_explicit(&r->transfers, 1, memory_order_relaxed);
+        offset += REPLAY_TRANSFER_BYTES;
+        if (offset >= r->len) offset = 0;
+    }
+    return NULL;
+}
+
+int replay_start(replay_t *r, const int8_t *data, size_t len, double rate_sps,
+                 replay_sink_t sink, void *ctx) {
+    if (!data || len < REPLAY_TRANSFER_BYTES || rate_sps <= 0.0 || !sink) return -1;
+    r->data = data;
+    r->len = len;
+    r->rate_sps = rate_sps;
+    r->sink = sink;
+    r->ctx = ctx;
+    atomic_store(&r->transfers, 0);
+    atomic_store(&r->late, 0);
+    atomic_store(&r->running, true);
+    if (pthread_create(&r->thread, NULL, pacer_main, r) != 0) {
+        atomic_store(&r->running, false);
+        return -1;
+    }
+    return 0;
+}
+
+void replay_stop(replay_t *r) {
+    if (!atomic_load(&r->running)) return;
+    atomic_store(&r->running, false);
+    pthread_join(r->thread, NULL);
+}
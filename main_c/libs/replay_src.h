@@ -0,0 +1,55 @@
+/**
+ * @file Drivers/replay_src.h
+ * @brief Paced CS8 sample source standing in for the HackRF RX stream
+ *
+ * Loops a recorded capture (the Samples/N CS8 format) or synthetic IQ and
+ * hands it to a sink in USB-sized transfers on absolute deadlines, so the
+ * consumer sees the same cadence as hackrf_start_rx at the given rate.
+ */
+
+#ifndef REPLAY_SRC_H
+#define REPLAY_SRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define REPLAY_TRANSFER_BYTES 262144    // libhackrf transfer buffer size
+
+/** Receives one transfer; return non-zero to stop the stream. */
+typedef int (*replay_sink_t)(const uint8_t *buf, size_t len, void *ctx);
+
+typedef struct {
+    const int8_t *data;         // Interleaved I/Q bytes, looped
+    size_t len;                 // Multiple of REPLAY_TRANSFER_BYTES
+    double rate_sps;
+    replay_sink_t sink;
+    void *ctx;
+    pthread_t thread;
+    atomic_bool running;
+    _Atomic uint64_t transfers;
+    _Atomic uint64_t late;      // Transfers issued behind their deadline
+} replay_t;
+
+/**
+ * @brief Reads a CS8 file, truncated to whole transfers.
+ * @return Buffer (free with free) or NULL.
+ */
+int8_t* replay_load_cs8(const char *path, size_t *len);
+
+/**
+ * @brief Three tones over noise, n_transfers transfers long.
+ */
+int8_t* replay_synth_cs8(size_t n_transfers, size_t *len);
+
+/**
+ * @brief Starts the pacing thread. Returns 0 on success.
+ */
+int replay_start(replay_t *r, const int8_t *data, size_t len, double rate_sps,
+                 replay_sink_t sink, void *ctx);
+
+void replay_stop(replay_t *r);
+
+#endif
@@ -2,6 +2,7 @@
  * @file Drivers/ring_buffer.c
  */
 #include "ring_buffer.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -39,7 +40,7 @@ void rb_reset(ring_buffer_t *rb) {
 }
 
 size_t rb_write(ring_buffer_t *rb, const void *data, size_t len) {
-    pthread_mutex_lock(&rb->lock);
+    trace_mutex_lock(&rb->lock, "lock:ring_buffer");
     
     size_t space_free = rb->size - (rb->head - rb->tail);
     size_t to_write = MIN(len, space_free);
@@ -64,7 +65,7 @@ size_t rb_write(ring_buffer_t *rb, const void *data, size_t len) {
 }
 
 size_t rb_read(ring_buffer_t *rb, void *data, size_t len) {
-    pthread_mutex_lock(&rb->lock);
+    trace_mutex_lock(&rb->lock, "lock:ring_buffer");
     
     size_t available = rb->head - rb->tail;
     size_t to_read = MIN(len, available);
@@ -88,7 +89,7 @@ size_t rb_read(ring_buffer_t *rb, void *data, size_t len) {
 }
 
 size_t rb_available(ring_buffer_t *rb) {
-    pthread_mutex_lock(&rb->lock);
+    trace_mutex_lock(&rb->lock, "lock:ring_buffer");
     size_t val = rb->head - rb->tail;
     pthread_mutex_unlock(&rb->lock);
     return val;
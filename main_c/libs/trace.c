@@ -0,0 +1,251 @@
+/**
+ * @file Drivers/trace.c
+ */
+
+#define _GNU_SOURCE
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    const char *name;
+    uint64_t ts_ns;
+    int64_t value;
+    char ph;
+} TraceEvent_t;
+
+// Single producer (the owning thread), single consumer (the flusher)
+typedef struct TraceBuf {
+    TraceEvent_t ev[TRACE_BUF_EVENTS];
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    atomic_bool dead;               // Owner exited; freed once drained
+    int tid;
+    struct TraceBuf *next;
+} TraceBuf_t;
+
+enum { TRACE_UNINIT = 0, TRACE_ON, TRACE_OFF };
+
+static atomic_int trace_state = TRACE_UNINIT;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+
+static FILE *trace_file = NULL;
+static bool first_event = true;
+static uint64_t t0_ns = 0;
+static int trace_pid = 0;
+
+static TraceBuf_t *buffers = NULL;
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t buf_key;
+static _Thread_local TraceBuf_t *tls_buf = NULL;
+static _Atomic unsigned long dropped = 0;
+
+static pthread_t flusher_thread;
+static atomic_bool running = false;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// =========================================================
+// FLUSHER
+// =========================================================
+
+static void write_event(const TraceBuf_t *b, const TraceEvent_t *e) {
+    fputs(first_event ? "\n" : ",\n", trace_file);
+    first_event = false;
+
+    if (e->ph == 'M') {
+        fprintf(trace_file,
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                trace_pid, b->tid, e->name);
+        return;
+    }
+
+    double ts_us = (double)(e->ts_ns - t0_ns) / 1000.0;
+    fprintf(trace_file, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+            e->name, e->ph, ts_us, trace_pid, b->tid);
+    if (e->ph == 'C') {
+        fprintf(trace_file, ",\"args\":{\"value\":%lld}", (long long)e->value);
+    } else if (e->ph == 'i') {
+        fputs(",\"s\":\"t\"", trace_file);
+    }
+    fputc('}', trace_file);
+}
+
+static void drain_buffer(TraceBuf_t *b) {
+    size_t tail = atomic_load_explicit(&b->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+    for (; tail != head; tail++) {
+        write_event(b, &b->ev[tail & (TRACE_BUF_EVENTS - 1)]);
+    }
+    atomic_store_explicit(&b->tail, tail, memory_order_release);
+}
+
+static void drain_all(void) {
+    pthread_mutex_lock(&buffers_lock);
+    TraceBuf_t **link = &buffers;
+    while (*link) {
+        TraceBuf_t *b = *link;
+        // Read 'dead' first: events pushed before the owner exited are then visible
+        bool dead = atomic_load(&b->dead);
+        drain_buffer(b);
+        if (dead) {
+            *link = b->next;
+            free(b);
+        } else {
+            link = &b->next;
+        }
+    }
+    pthread_mutex_unlock(&buffers_lock);
+    fflush(trace_file);
+}
+
+static void *flusher_main(void *arg) {
+    (void)arg;
+    struct timespec period = { TRACE_FLUSH_MS / 1000, (TRACE_FLUSH_MS % 1000) * 1000000L };
+    while (atomic_load(&running)) {
+        nanosleep(&period, NULL);
+        drain_all();
+    }
+    return NULL;
+}
+
+// =========================================================
+// INIT / SHUTDOWN
+// =========================================================
+
+static void buf_destructor(void *p) {
+    TraceBuf_t *b = p;
+    if (b) atomic_store(&b->dead, true);
+}
+
+static void trace_init(void) {
+    const char *path = getenv(TRACE_ENV);
+    if (!path || !*path) {
+        atomic_store(&trace_state, TRACE_OFF);
+        return;
+    }
+
+    trace_file = fopen(path, "w");
+    if (!trace_file) {
+        fprintf(stderr, "[TRACE] Cannot open %s, tracing disabled.\n", path);
+        atomic_store(&trace_state, TRACE_OFF);
+        return;
+    }
+    // The array is closed at exit; viewers also accept a truncated file
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", trace_file);
+
+    pthread_key_create(&buf_key, buf_destructor);
+    t0_ns = now_ns();
+    trace_pid = (int)getpid();
+
+    atomic_store(&running, true);
+    if (pthread_create(&flusher_thread, NULL, flusher_main, NULL) != 0) {
+        fprintf(stderr, "[TRACE] Could not start flusher thread, tracing disabled.\n");
+        atomic_store(&running, false);
+        fclose(trace_file);
+        trace_file = NULL;
+        atomic_store(&trace_state, TRACE_OFF);
+        return;
+    }
+
+    atexit(trace_shutdown);
+    atomic_store(&trace_state, TRACE_ON);
+    fprintf(stderr, "[TRACE] Writing trace events to %s\n", path);
+}
+
+bool trace_enabled(void) {
+    int s = atomic_load_explicit(&trace_state, memory_order_relaxed);
+    if (s == TRACE_UNINIT) {
+        pthread_once(&trace_once, trace_init);
+        s = atomic_load(&trace_state);
+    }
+    return s == TRACE_ON;
+}
+
+void trace_shutdown(void) {
+    int expected = TRACE_ON;
+    if (!atomic_compare_exchange_strong(&trace_state, &expected, TRACE_OFF)) return;
+
+    atomic_store(&running, false);
+    pthread_join(flusher_thread, NULL);
+    drain_all();
+
+    fputs("\n]}\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+
+    unsigned long n = atomic_load(&dropped);
+    if (n > 0) fprintf(stderr, "[TRACE] %lu events dropped (buffer full).\n", n);
+}
+
+// =========================================================
+// RECORDING
+// =========================================================
+
+static TraceBuf_t *thread_buffer(void) {
+    if (tls_buf) return tls_buf;
+
+    TraceBuf_t *b = calloc(1, sizeof(TraceBuf_t));
+    if (!b) return NULL;
+    b->tid = (int)syscall(SYS_gettid);
+
+    pthread_mutex_lock(&buffers_lock);
+    b->next = buffers;
+    buffers = b;
+    pthread_mutex_unlock(&buffers_lock);
+
+    pthread_setspecific(buf_key, b);
+    tls_buf = b;
+    return b;
+}
+
+static void push_event(char ph, const char *name, int64_t value) {
+    if (!trace_enabled()) return;
+    TraceBuf_t *b = thread_buffer();
+    if (!b) return;
+
+    size_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&b->tail, memory_order_acquire);
+    if (head - tail >= TRACE_BUF_EVENTS) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent_t *e = &b->ev[head & (TRACE_BUF_EVENTS - 1)];
+    e->name = name;
+    e->ts_ns = now_ns();
+    e->value = value;
+    e->ph = ph;
+    atomic_store_explicit(&b->head, head + 1, memory_order_release);
+}
+
+void trace_begin(const char *name) { push_event('B', name, 0); }
+
+void trace_end(const char *name) { push_event('E', name, 0); }
+
+void trace_instant(const char *name) { push_event('i', name, 0); }
+
+void trace_counter(const char *name, int64_t value) { push_event('C', name, value); }
+
+void trace_thread_name(const char *name) { push_event('M', name, 0); }
+
+void trace_mutex_lock(pthread_mutex_t *m, const char *name) {
+    if (!trace_enabled()) {
+        pthread_mutex_lock(m);
+        return;
+    }
+    if (pthread_mutex_trylock(m) == 0) return;
+
+    trace_begin(name);
+    pthread_mutex_lock(m);
+    trace_end(name);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file Drivers/trace.h
+ * @brief Optional Chrome/Perfetto trace-event recorder
+ *
+ * Enabled by setting RF_TRACE to an output path (e.g. RF_TRACE=/tmp/rf.json);
+ * when unset every call is a single flag test. Each thread appends events to
+ * its own lock-free buffer; a background thread drains the buffers into a
+ * Chrome trace JSON file (load it in chrome://tracing or ui.perfetto.dev).
+ * Events are dropped, and counted, if a thread outruns the flusher.
+ *
+ * Event names are stored by pointer: pass string literals only.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define TRACE_ENV          "RF_TRACE"
+#define TRACE_BUF_EVENTS   8192        // Per thread; must be a power of two
+#define TRACE_FLUSH_MS     200
+
+/**
+ * @brief True when tracing is on. The first call reads RF_TRACE, opens the
+ * file and starts the flusher; the file is finalised at exit.
+ */
+bool trace_enabled(void);
+
+/** @brief Opens a duration slice on the calling thread ("B" event). */
+void trace_begin(const char *name);
+
+/** @brief Closes the innermost slice opened with the same name ("E" event). */
+void trace_end(const char *name);
+
+/** @brief Zero-length marker, e.g. one per USB transfer ("i" event). */
+void trace_instant(const char *name);
+
+/** @brief Sample of a named counter track ("C" event). */
+void trace_counter(const char *name, int64_t value);
+
+/** @brief Labels the calling thread in the viewer. */
+void trace_thread_name(const char *name);
+
+/**
+ * @brief pthread_mutex_lock that shows contention: when the mutex is busy
+ * the time spent blocked appears as a slice named @p name.
+ */
+void trace_mutex_lock(pthread_mutex_t *m, const char *name);
+
+/** @brief Drains all buffers and closes the JSON file. Idempotent. */
+void trace_shutdown(void);
+
+#endif
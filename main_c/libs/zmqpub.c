@@ -8,11 +8,23 @@
 #include <string.h>
 
 zpub_t* zpub_init(void) {
+    return zpub_init_ex(0, false);
+}
+
+zpub_t* zpub_init_ex(int sndhwm, bool conflate) {
     zpub_t *pub = malloc(sizeof(zpub_t));
     if (!pub) return NULL;
 
     pub->context = zmq_ctx_new();
     pub->socket = zmq_socket(pub->context, ZMQ_PUB);
+    pub->conflate = conflate;
+
+    // Options must be set before bind to apply to every subscriber pipe
+    if (sndhwm > 0) zmq_setsockopt(pub->socket, ZMQ_SNDHWM, &sndhwm, sizeof(sndhwm));
+    if (conflate) {
+        int on = 1;
+        zmq_setsockopt(pub->socket, ZMQ_CONFLATE, &on, sizeof(on));
+    }
 
     // BINDING: The Publisher creates the file. 
     // The Python Subscriber will CONNECT to this.
@@ -20,6 +32,8 @@ zpub_t* zpub_init(void) {
     
     if (rc != 0) {
         fprintf(stderr, "[ZPUB] Error: Could not bind to %s. (Is another process holding it?)\n", PUB_IPC_ADDR);
+        zmq_close(pub->socket);
+        zmq_ctx_term(pub->context);
         free(pub);
         return NULL;
     }
@@ -50,6 +64,89 @@ int zpub_publish(zpub_t *pub, const char *topic, const char *json_payload) {
     return bytes_sent;
 }
 
+// Conflate mode: one "TOPIC f0f1..." frame, the only form ZMQ can conflate
+static int publish_joined(zpub_t *pub, const char *topic, const void *const *frames, const size_t *lens, int n_frames) {
+    size_t tlen = strlen(topic);
+    size_t total = tlen + 1;
+    for (int i = 0; i < n_frames; i++) total += lens[i];
+
+    zmq_msg_t msg;
+    if (zmq_msg_init_size(&msg, total) != 0) return -1;
+    char *p = zmq_msg_data(&msg);
+    memcpy(p, topic, tlen);
+    p[tlen] = ' ';
+    p += tlen + 1;
+    for (int i = 0; i < n_frames; i++) {
+        memcpy(p, frames[i], lens[i]);
+        p += lens[i];
+    }
+
+    int rc = zmq_msg_send(&msg, pub->socket, 0);
+    if (rc < 0) {
+        zmq_msg_close(&msg);
+        return -1;
+    }
+    return rc - (int)(tlen + 1);
+}
+
+int zpub_publish_multipart(zpub_t *pub, const char *topic, const void *const *frames, const size_t *lens, int n_frames) {
+    if (!pub || !topic || (n_frames > 0 && (!frames || !lens))) return -1;
+    if (pub->conflate) return publish_joined(pub, topic, frames, lens, n_frames);
+
+    // 1. Topic frame (subscribers filter on it)
+    int flags = (n_frames > 0) ? ZMQ_SNDMORE : 0;
+    if (zmq_send(pub->socket, topic, strlen(topic), flags) < 0) return -1;
+
+    // 2. Data frames, all but the last flagged SNDMORE
+    int total = 0;
+    for (int i = 0; i < n_frames; i++) {
+        flags = (i < n_frames - 1) ? ZMQ_SNDMORE : 0;
+        int rc = zmq_send(pub->socket, frames[i], lens[i], flags);
+        if (rc < 0) return -1;
+        total += rc;
+    }
+    return total;
+}
+
+void zpub_free_default(void *data, void *hint) {
+    (void)hint;
+    free(data);
+}
+
+int zpub_publish_owned(zpub_t *pub, const char *topic, const void *head, size_t head_len,
+                       void *data, size_t len, zpub_free_fn *free_fn, void *hint) {
+    if (!pub || !topic || !data) {
+        if (data && free_fn) free_fn(data, hint);
+        return -1;
+    }
+
+    if (pub->conflate) {
+        const void *frames[2] = { head, data };
+        size_t lens[2] = { head_len, len };
+        int rc = head ? publish_joined(pub, topic, frames, lens, 2)
+                      : publish_joined(pub, topic, frames + 1, lens + 1, 1);
+        if (free_fn) free_fn(data, hint);
+        return rc;
+    }
+
+    // 1. Topic frame and optional head, copied
+    if (zmq_send(pub->socket, topic, strlen(topic), ZMQ_SNDMORE) < 0 ||
+        (head && zmq_send(pub->socket, head, head_len, ZMQ_SNDMORE) < 0)) {
+        if (free_fn) free_fn(data, hint);
+        return -1;
+    }
+
+    // 2. Payload frame: ZMQ keeps the pointer and calls free_fn when done
+    zmq_msg_t msg;
+    if (zmq_msg_init_data(&msg, data, len, free_fn, hint) != 0) {
+        if (free_fn) free_fn(data, hint);
+        return -1;
+    }
+    int rc = zmq_msg_send(&msg, pub->socket, 0);
+    if (rc < 0) zmq_msg_close(&msg);    // Runs free_fn
+    return rc;
+}
+
 void zpub_close(zpub_t *pub) {
     if (pub) {
         if (pub->socket) zmq_close(pub->socket);
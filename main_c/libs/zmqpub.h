@@ -7,6 +7,8 @@
 #define ZMQPUB_H
 
 #include <zmq.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 // We use a DIFFERENT address for results to avoid locking conflicts 
 // with the command channel.
@@ -16,14 +18,28 @@
 typedef struct {
     void *context;
     void *socket;
+    bool conflate;      // Multipart is not conflatable: frames are joined
 } zpub_t;
 
+/** Releases a payload handed to zpub_publish_owned() once ZMQ is done with it.
+ *  May run on a ZMQ I/O thread. */
+typedef void (zpub_free_fn)(void *data, void *hint);
+
 /**
  * @brief Initialize the Publisher
  * @return Pointer to zpub_t struct
  */
 zpub_t* zpub_init(void);
 
+/**
+ * @brief Initialize the Publisher with slow-subscriber options
+ * @param sndhwm Messages queued per subscriber before dropping (0 = ZMQ default)
+ * @param conflate Keep only the newest message per subscriber. ZMQ cannot
+ *        conflate multipart messages, so in this mode every message is sent
+ *        as a single "TOPIC PAYLOAD" frame (one copy, as zpub_publish).
+ */
+zpub_t* zpub_init_ex(int sndhwm, bool conflate);
+
 /**
  * @brief Sends a message in the format "TOPIC JSON_STRING"
  * Matches Python: full_msg.split(" ", 1)
@@ -34,6 +50,28 @@ zpub_t* zpub_init(void);
  */
 int zpub_publish(zpub_t *pub, const char *topic, const char *json_payload);
 
+/**
+ * @brief Sends a multipart message: [topic][frame 0]...[frame n-1]
+ * Used for binary results (see psd_wire.h); frames are copied by ZMQ.
+ * @return Payload bytes sent (topic excluded), or -1 on error
+ */
+int zpub_publish_multipart(zpub_t *pub, const char *topic, const void *const *frames, const size_t *lens, int n_frames);
+
+/**
+ * @brief Sends [topic][head][payload] without copying the payload: ownership
+ * of data passes to ZMQ, which calls free_fn(data, hint) after sending.
+ * free_fn is also called if the send fails, so the caller never frees data.
+ * @param head Optional small frame sent (copied) before the payload, or NULL
+ * @return Payload bytes sent, or -1 on error
+ */
+int zpub_publish_owned(zpub_t *pub, const char *topic, const void *head, size_t head_len,
+                       void *data, size_t len, zpub_free_fn *free_fn, void *hint);
+
+/**
+ * @brief zpub_free_fn for buffers obtained with malloc()
+ */
+void zpub_free_default(void *data, void *hint);
+
 /**
  * @brief Closes socket and context
  */
@@ -9,24 +9,60 @@
 #include <pthread.h>
 #include "zmqsub.h"
 
+// Copies len bytes into the NUL-terminated scratch buffer, growing it as needed
+static char* sub_store(zsub_t *sub, const void *data, size_t len) {
+    if (len + 1 > sub->buf_cap) {
+        size_t cap = sub->buf_cap ? sub->buf_cap : ZSUB_BUF_SIZE;
+        while (cap < len + 1) cap *= 2;
+        char *grown = realloc(sub->buffer, cap);
+        if (!grown) return NULL;
+        sub->buffer = grown;
+        sub->buf_cap = cap;
+    }
+    memcpy(sub->buffer, data, len);
+    sub->buffer[len] = '\0';
+    return sub->buffer;
+}
+
 static void* listener_thread(void *arg) {
     zsub_t *sub = (zsub_t*)arg;
-    
+    zmq_msg_t msg;
+
     while (sub->running) {
         // Attempt to receive (blocks for max 1 second due to RCVTIMEO)
-        int len = zmq_recv(sub->socket, sub->buffer, ZSUB_BUF_SIZE - 1, 0);
-        
+        zmq_msg_init(&msg);
+        int len = zmq_msg_recv(&msg, sub->socket, 0);
+
         if (len > 0) {
-            sub->buffer[len] = '\0';
-            char *json_payload = strchr(sub->buffer, ' ');
+            // "topic json" in one frame, or [topic][json] as multipart
+            int parts = 1;
+            while (zmq_msg_more(&msg)) {
+                zmq_msg_close(&msg);
+                zmq_msg_init(&msg);
+                if (zmq_msg_recv(&msg, sub->socket, 0) < 0) break;
+                parts++;
+            }
+
+            char *text = sub_store(sub, zmq_msg_data(&msg), zmq_msg_size(&msg));
+            char *json_payload = NULL;
+            if (!text) {
+                fprintf(stderr, "[ZMQ] Error: no memory for %zu byte message\n", zmq_msg_size(&msg));
+            } else if (parts > 1) {
+                json_payload = text;
+            } else {
+                char *space = strchr(text, ' ');
+                if (space) json_payload = space + 1;
+            }
+
             if (json_payload && sub->callback) {
-                sub->callback(json_payload + 1);
+                sub->callback(json_payload);
             }
         } else {
             // This else block runs when we time out. 
             // The thread is "awake" here but found no data.
             // It allows the while(sub->running) check to happen.
         }
+        zmq_msg_close(&msg);
     }
     return NULL;
 }
@@ -37,6 +73,8 @@ zsub_t* zsub_init(const char *topic, msg_callback_t cb) {
     sub->socket = zmq_socket(sub->context, ZMQ_SUB);
     sub->callback = cb;
     sub->running = 0;
+    sub->buffer = NULL;
+    sub->buf_cap = 0;
 
     // FIX 1: Set a 1-second timeout so the thread wakes up to check 'running' flag
     int timeout = 1000; 
@@ -59,6 +97,7 @@ void zsub_close(zsub_t *sub) {
     pthread_join(sub->thread_id, NULL); // Wait for current timeout cycle to finish
     zmq_close(sub->socket);
     zmq_ctx_term(sub->context);
+    free(sub->buffer);
     free(sub);
 }
 
@@ -8,7 +8,7 @@
 #include <pthread.h>
 
 #define IPC_ADDR "ipc:///tmp/zmq_feed"
-#define ZSUB_BUF_SIZE 1024
+#define ZSUB_BUF_SIZE 1024     // Initial size; grows to fit each message
 
 // Define the type for the function you want to run when data arrives
 typedef void (*msg_callback_t)(const char *payload);
@@ -16,7 +16,8 @@ typedef void (*msg_callback_t)(const char *payload);
 typedef struct {
     void *context;
     void *socket;
-    char buffer[ZSUB_BUF_SIZE];
+    char *buffer;
+    size_t buf_cap;
     pthread_t thread_id;
     msg_callback_t callback; // Pointer to your processing function
     int running;
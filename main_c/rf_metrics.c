@@ -14,8 +14,8 @@
 #include <string.h>
 #include <inttypes.h>
 #include <time.h>
-#include <sys/sysinfo.h>
-#include <sys/statvfs.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -30,6 +30,13 @@
 #include "ring_buffer.h" 
 #include "zmqsub.h"
 #include "zmqpub.h"
+#include "psd_wire.h"
+#include "cmd_queue.h"
+#include "psd_shm.h"
+#include "metrics_log.h"
+#include "latency_hist.h"
+#include "trace.h"
+#include "replay_src.h"
 
 
 
@@ -38,21 +45,12 @@
 // =========================================================
 #define CSV_FOLDER "CSV_metrics_psdSDRService"
 
-typedef struct {
-    double acq_time_ms;
-    double dsp_time_ms;
-    double cpu_usage_percent;
-    unsigned long ram_used_mb;
-    unsigned long swap_used_mb;
-    double disk_usage_percent;
-} SystemMetrics_t;
-
-// Static buffer for the CSV filename
-char csv_filename[256] = {0};
+// Results publisher: a few cycles of backlog per subscriber, then drop.
+// Overridable with RF_PUB_HWM / RF_PUB_CONFLATE=1 (latest-only).
+#define PUB_SNDHWM 8
 
-// CPU Load tracking state
-unsigned long long prev_user = 0, prev_nice = 0, prev_system = 0, prev_idle = 0;
-unsigned long long prev_iowait = 0, prev_irq = 0, prev_softirq = 0, prev_steal = 0;
+// Stage latency histograms go out on LAT_STATS_TOPIC this often (and on SIGUSR1)
+#define STATS_PERIOD_S 10
 
 // =========================================================
 // SDR GLOBAL VARIABLES
@@ -65,13 +63,30 @@ zpub_t *publisher = NULL;
 
 // State Flags
 volatile bool stop_streaming = false;
-volatile bool config_received = false; 
+static volatile sig_atomic_t stats_dump_requested = 0;
+
+// Set by the first RX callback of a capture (0 = no sample yet)
+static _Atomic uint64_t first_sample_ns = 0;
 
-// Configuration Containers
-DesiredCfg_t desired_config = {0};
-PsdConfig_t psd_cfg = {0};
-SDR_cfg_t hack_cfg = {0};
-RB_cfg_t rb_cfg = {0};
+// Bytes the RX callback could not fit in the ring buffer (overrun)
+static _Atomic uint64_t rx_dropped_bytes = 0;
+
+// One queued measurement: requested config, derived configs and its capture
+typedef struct {
+    DesiredCfg_t desired;
+    SDR_cfg_t hack;
+    PsdConfig_t psd;
+    PsdPlan_t *plan;        // Shared snapshot: psd + window + FFTW plan
+    RB_cfg_t rb;
+    int8_t *samples;        // Captured IQ (rb.total_bytes), NULL until acquired
+    double t_start_acq;
+    double t_end_acq;
+    uint64_t t_cycle_ns;    // Retune start, for the whole-cycle latency
+    uint64_t t_rx_ns;       // hackrf_start_rx call
+} MeasureJob_t;
+
+// Commands from the listener thread, consumed in order by the main loop
+cmd_queue_t job_queue;
 
 // =========================================================
 // METRIC HELPER FUNCTIONS
@@ -84,168 +99,49 @@ double get_time_ms() {
     return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
 }
 
-// Retrieve MAC address (Try wlan0, fallback to eth0)
-void get_mac_address(char *buffer) {
-    char path[128];
-    FILE *f;
-    const char *interfaces[] = {"wlan0", "eth0", "en0"};
-    
-    for (int i = 0; i < 3; i++) {
-        snprintf(path, sizeof(path), "/sys/class/net/%s/address", interfaces[i]);
-        f = fopen(path, "r");
-        if (f) {
-            if (fgets(buffer, 18, f)) {
-                fclose(f);
-                buffer[strcspn(buffer, "\n")] = 0; // Remove newline
-                return;
-            }
-            fclose(f);
-        }
-    }
-    strcpy(buffer, "UNKNOWN_MAC");
-}
-
-// Calculate CPU usage delta
-double get_cpu_load() {
-    FILE *fp = fopen("/proc/stat", "r");
-    if (!fp) return 0.0;
-
-    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-    char buffer[1024];
-    if (!fgets(buffer, sizeof(buffer), fp)) { fclose(fp); return 0.0; }
-    sscanf(buffer, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu", 
-           &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
-    fclose(fp);
-
-    unsigned long long prev_idle_total = prev_idle + prev_iowait;
-    unsigned long long idle_total = idle + iowait;
-
-    unsigned long long prev_non_idle = prev_user + prev_nice + prev_system + prev_irq + prev_softirq + prev_steal;
-    unsigned long long non_idle = user + nice + system + irq + softirq + steal;
-
-    unsigned long long prev_total = prev_idle_total + prev_non_idle;
-    unsigned long long total = idle_total + non_idle;
-
-    double total_d = (double)(total - prev_total);
-    double id_d = (double)(idle_total - prev_idle_total);
-    
-    // Update State
-    prev_user = user; prev_nice = nice; prev_system = system; prev_idle = idle;
-    prev_iowait = iowait; prev_irq = irq; prev_softirq = softirq; prev_steal = steal;
-
-    if (total_d == 0) return 0.0;
-    return ((total_d - id_d) / total_d) * 100.0;
-}
-
-// Initialize CSV File and Headers
-void init_csv_filename() {
-    struct stat st = {0};
-    if (stat(CSV_FOLDER, &st) == -1) {
-        mkdir(CSV_FOLDER, 0777);
-    }
-
-    char mac[32];
-    get_mac_address(mac);
-    // Sanitize MAC for filename
-    for(int i=0; mac[i]; i++) { if(mac[i] == ':') mac[i] = '-'; }
-
-    time_t t = time(NULL);
-    struct tm tm = *localtime(&t);
-
-    snprintf(csv_filename, sizeof(csv_filename), 
-             "%s/%04d%02d%02d_%02d%02d%02d_%s.csv",
-             CSV_FOLDER,
-             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-             tm.tm_hour, tm.tm_min, tm.tm_sec,
-             mac);
-    
-    FILE *fp = fopen(csv_filename, "a");
-    if (fp) {
-        fseek(fp, 0, SEEK_END);
-        if (ftell(fp) == 0) {
-            fprintf(fp, "Timestamp_Epoch,Acq_Time_ms,PSD_Calc_Time_ms,"
-                        "CPU_Load_Pct,RAM_Used_MB,RAM_Total_MB,Swap_Used_MB,Disk_Usage_Pct,"
-                        "CenterFreq_Hz,RBW_Hz,SampleRate_Hz,Span_Hz,Overlap,Scale,Window,LNA,VGA,Amp,PSD_Bins\n");
-        }
-        fclose(fp);
-    }
-}
-
-// Gather System Stats
-void collect_system_metrics(SystemMetrics_t *m) {
-    struct sysinfo si;
-    if (sysinfo(&si) == 0) {
-        m->ram_used_mb = (unsigned long)((si.totalram - si.freeram) * si.mem_unit / 1024 / 1024);
-        m->swap_used_mb = (unsigned long)((si.totalswap - si.freeswap) * si.mem_unit / 1024 / 1024);
-    } else {
-        m->ram_used_mb = 0; m->swap_used_mb = 0;
-    }
-
-    struct statvfs stat;
-    if (statvfs(".", &stat) == 0) {
-        unsigned long long total = stat.f_blocks;
-        unsigned long long free = stat.f_bfree;
-        if (total > 0) m->disk_usage_percent = (1.0 - ((double)free / (double)total)) * 100.0;
-        else m->disk_usage_percent = 0.0;
-    }
-
-    m->cpu_usage_percent = get_cpu_load();
-}
-
-// Write to CSV
-void log_to_csv(SystemMetrics_t *m, DesiredCfg_t *cfg, int psd_len) {
-    FILE *fp = fopen(csv_filename, "a");
-    if (!fp) return;
-
-    struct sysinfo si;
-    unsigned long ram_total = 0;
-    if(sysinfo(&si) == 0) ram_total = (si.totalram * si.mem_unit) / 1024 / 1024;
-
-    fprintf(fp, "%ld,%.2f,%.2f,%.2f,%lu,%lu,%lu,%.2f,"
-                "%" PRIu64 ",%d,%.0f,%.0f,%.2f,%s,%d,%d,%d,%d,%d\n",
-            time(NULL), 
-            m->acq_time_ms, 
-            m->dsp_time_ms,
-            m->cpu_usage_percent,
-            m->ram_used_mb,
-            ram_total,
-            m->swap_used_mb,
-            m->disk_usage_percent,
-            cfg->center_freq,
-            cfg->rbw,
-            cfg->sample_rate,
-            cfg->span,
-            cfg->overlap,
-            cfg->scale ? cfg->scale : "dBm",
-            cfg->window_type,
-            cfg->lna_gain,
-            cfg->vga_gain,
-            cfg->amp_enabled ? 1 : 0,
-            psd_len
-            );
-    fclose(fp);
-}
-
 // =========================================================
 // CONFIG LOGIC & PARSING
 // =========================================================
 
 
-void print_desired(const DesiredCfg_t *cfg) {
-    printf("  [CFG] Freq: %" PRIu64 " | RBW: %d | Scale: %s\n", 
-           cfg->center_freq, cfg->rbw, cfg->scale ? cfg->scale : "dBm");
+void print_desired(const DesiredCfg_t *cfg, const PsdConfig_t *psd_cfg) {
+    printf("  [CFG] Freq: %" PRIu64 " | RBW: %d | Scale: %s | Id: %s\n", 
+           cfg->center_freq, cfg->rbw, cfg->scale ? cfg->scale : "dBm",
+           cfg->request_id ? cfg->request_id : "-");
+    printf("  [PSD] nperseg: %d | Decimation: %d | Actual RBW: %.2f Hz\n",
+           psd_cfg->nperseg, psd_cfg->decimation, psd_cfg->rbw_actual);
 }
 
 
 
 int find_params_psd(DesiredCfg_t desired, SDR_cfg_t *hack_cfg, PsdConfig_t *psd_cfg, RB_cfg_t *rb_cfg) {
-    double enbw_factor = get_window_enbw_factor(desired.window_type);
-    double required_nperseg_val = enbw_factor * (double)desired.sample_rate / (double)desired.rbw;
-    int exponent = (int)ceil(log2(required_nperseg_val));
-    
-    psd_cfg->nperseg = (int)pow(2, exponent);
+    double enbw_factor = psd_window_enbw(desired.window_type, desired.window_param);
+    size_t n_samples = (size_t)desired.sample_rate;    // One second of capture
+
+    // Narrow spans: decimate first so the FFT only covers the span. A smaller
+    // ratio is taken when the decimated stream would not fill one segment.
+    int decimation = psd_ddc_pick_decimation(desired.sample_rate, desired.span, n_samples, 0);
+    for (;;) {
+        double psd_rate = desired.sample_rate / decimation;
+        double required_nperseg_val = enbw_factor * psd_rate / (double)desired.rbw;
+
+        if (desired.fft_sizing == FFT_SIZE_SMOOTH) {
+            psd_cfg->nperseg = psd_next_smooth_size((int)ceil(required_nperseg_val));
+        } else {
+            int exponent = (int)ceil(log2(required_nperseg_val));
+            psd_cfg->nperseg = (int)pow(2, exponent);
+        }
+        if (decimation == 1 || n_samples / decimation >= (size_t)psd_cfg->nperseg) break;
+        decimation = psd_ddc_pick_decimation(desired.sample_rate, desired.span, n_samples, psd_cfg->nperseg);
+    }
+    psd_cfg->decimation = decimation;
+    psd_cfg->nco_offset_hz = desired.nco_offset_hz;
+    double psd_rate = desired.sample_rate / decimation;
+    psd_cfg->rbw_actual = enbw_factor * psd_rate / (double)psd_cfg->nperseg;
     psd_cfg->noverlap = psd_cfg->nperseg * desired.overlap;
     psd_cfg->window_type = desired.window_type;
+    psd_cfg->window_param = desired.window_param;
+    psd_cfg->exact_log = desired.exact_log;
     psd_cfg->sample_rate = desired.sample_rate;
 
     hack_cfg->sample_rate = desired.sample_rate;
@@ -265,8 +161,22 @@ int find_params_psd(DesiredCfg_t desired, SDR_cfg_t *hack_cfg, PsdConfig_t *psd_
 // =========================================================
 
 int rx_callback(hackrf_transfer* transfer) {
+    static _Thread_local bool trace_named = false;
+    if (!trace_named) {
+        trace_thread_name("usb_rx");
+        trace_named = true;
+    }
+    trace_instant("usb_transfer");
+
     if (stop_streaming) return -1;
-    rb_write(&rb, transfer->buffer, transfer->valid_length);
+    if (atomic_load_explicit(&first_sample_ns, memory_order_relaxed) == 0) {
+        atomic_store_explicit(&first_sample_ns, lat_now_ns(), memory_order_relaxed);
+    }
+    size_t written = rb_write(&rb, transfer->buffer, transfer->valid_length);
+    if (written < (size_t)transfer->valid_length) {
+        atomic_fetch_add_explicit(&rx_dropped_bytes, (size_t)transfer->valid_length - written,
+                                  memory_order_relaxed);
+    }
     return 0;
 }
 
@@ -292,60 +202,578 @@ int recover_hackrf(void) {
     return -1;
 }
 
-void publish_results(double* freq_array, double* psd_array, int length) {
-    if (!publisher || !freq_array || !psd_array) return;
+static void publish_results_binary(const MeasureJob_t* job, const PsdAxis_t* axis, double* psd_array, int length) {
+    // One reference trace per config, so interleaved batch jobs still get deltas
+    static PsdWireEncoderTable_t encoders = {0};
+    uint8_t header[PSD_WIRE_HEADER_MAX];
+    const DesiredCfg_t *cfg = &job->desired;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    PsdWireHeader_t hdr = {
+        .start_hz = axis->start_hz + (double)job->hack.center_freq,
+        .step_hz = axis->step_hz,
+        .bins = (uint32_t)length,
+        .units = (uint8_t)psd_parse_unit(cfg->scale),
+        .timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec,
+        .config_hash = psd_config_hash(cfg),
+        .request_id = cfg->request_id,
+    };
+
+    uint64_t t0 = lat_now_ns();
+    PsdWireEncoder_t *encoder = psd_wire_encoder_lookup(&encoders, hdr.config_hash);
+    psd_wire_encoder_config(encoder, cfg->wire_encoding,
+                            cfg->quant_step_db, cfg->keyframe_interval);
+    size_t payload_len = 0;
+    if (!psd_wire_encode(encoder, &hdr, psd_array, (size_t)length, &payload_len)) return;
+    size_t header_len = psd_wire_pack_header(&hdr, header);
+    t0 = lat_record_since(LAT_ENCODE, t0);
+
+    // Header is small and copied; the payload buffer is handed to ZMQ
+    uint8_t *payload = psd_wire_take_payload(encoder);
+    zpub_publish_owned(publisher, PSD_WIRE_TOPIC, header, header_len,
+                       payload, payload_len, zpub_free_default, NULL);
+    lat_record_since(LAT_PUBLISH, t0);
+    printf("[ZMQ] Published binary results (%d bins, %zu bytes)\n", length, payload_len);
+}
+
+// Created on first use; lives until the process exits
+static psd_shm_t *shm_ring = NULL;
+
+static int publish_results_shm(const MeasureJob_t* job, const PsdAxis_t* axis, double* psd_array, int length) {
+    if (!shm_ring) shm_ring = psd_shm_create(0, 0);
+    if (!shm_ring) return -1;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    PsdShmMeta_t meta = {
+        .start_hz = axis->start_hz + (double)job->hack.center_freq,
+        .step_hz = axis->step_hz,
+        .units = (uint8_t)psd_parse_unit(job->desired.scale),
+        .timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec,
+        .config_hash = psd_config_hash(&job->desired),
+        .request_id = job->desired.request_id,
+    };
+
+    uint64_t t0 = lat_now_ns();
+    uint64_t frame = 0;
+    int slot = psd_shm_write(shm_ring, &meta, psd_array, length, &frame);
+    if (slot < 0) return -1;
+    t0 = lat_record_since(LAT_ENCODE, t0);
+
+    // Slot index plus frame number, so readers can spot a re-created ring
+    uint8_t note[PSD_SHM_NOTIFY_LEN];
+    psd_shm_pack_notify(slot, frame, note);
+    const void *frames[1] = { note };
+    size_t lens[1] = { sizeof(note) };
+    zpub_publish_multipart(publisher, PSD_SHM_TOPIC, frames, lens, 1);
+    lat_record_since(LAT_PUBLISH, t0);
+    printf("[SHM] Published results to slot %d (%d bins)\n", slot, length);
+    return 0;
+}
+
+void publish_results(const MeasureJob_t* job, const PsdAxis_t* axis, double* psd_array, int length) {
+    if (!publisher || !job || !axis || !psd_array) return;
 
+    if (job->desired.output_format == OUTPUT_BINARY) {
+        publish_results_binary(job, axis, psd_array, length);
+        return;
+    }
+    if (job->desired.output_format == OUTPUT_SHM) {
+        if (publish_results_shm(job, axis, psd_array, length) == 0) return;
+        // Ring unavailable or trace too large: fall back to the binary message
+        publish_results_binary(job, axis, psd_array, length);
+        return;
+    }
+
+    double start_hz = axis->start_hz + (double)job->hack.center_freq;
+
+    uint64_t t0 = lat_now_ns();
     cJSON *root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "start_freq_hz", freq_array[0] + (double)hack_cfg.center_freq);
-    cJSON_AddNumberToObject(root, "end_freq_hz", freq_array[length-1] + (double)hack_cfg.center_freq);
+    if (job->desired.request_id) {
+        cJSON_AddStringToObject(root, "request_id", job->desired.request_id);
+    }
+    cJSON_AddNumberToObject(root, "start_freq_hz", start_hz);
+    cJSON_AddNumberToObject(root, "end_freq_hz", start_hz + (length - 1) * axis->step_hz);
     cJSON_AddNumberToObject(root, "bin_count", length);
+    cJSON_AddNumberToObject(root, "rbw_hz", job->psd.rbw_actual);
 
     cJSON *pxx_array = cJSON_CreateDoubleArray(psd_array, length);
     cJSON_AddItemToObject(root, "Pxx", pxx_array);
 
     char *json_string = cJSON_PrintUnformatted(root); 
-    zpub_publish(publisher, "data", json_string);
+    cJSON_Delete(root);
+    if (!json_string) return;
+    t0 = lat_record_since(LAT_ENCODE, t0);
+
+    // [data][json] frames; ZMQ frees the string once it is on the wire
+    zpub_publish_owned(publisher, "data", NULL, 0, json_string, strlen(json_string), zpub_free_default, NULL);
+    lat_record_since(LAT_PUBLISH, t0);
     printf("[ZMQ] Published results (%d bins)\n", length);
+}
 
-    free(json_string);
-    cJSON_Delete(root);
+static void free_job(MeasureJob_t *job) {
+    if (!job) return;
+    free_desired_psd(&job->desired);
+    psd_plan_release(job->plan);
+    free(job->samples);
+    free(job);
 }
 
+/**
+ * Listener thread: a message holds one config or a "measurements" batch.
+ * Every config becomes a job; nothing is overwritten while a cycle runs.
+ */
 void handle_psd_message(const char *payload) {
     printf("\n>>> [ZMQ] Received Command Payload.\n");
-    free_desired_psd(&desired_config); 
-    memset(&desired_config, 0, sizeof(DesiredCfg_t));
+    trace_thread_name("zmq_listener");
+    trace_begin("parse_command");
 
-    if (parse_psd_config(payload, &desired_config) == 0) {
-        find_params_psd(desired_config, &hack_cfg, &psd_cfg, &rb_cfg);
-        print_desired(&desired_config);
-        config_received = true; 
-    } else {
+    DesiredCfg_t *cfgs = NULL;
+    int n = parse_psd_batch(payload, &cfgs);
+    if (n < 0) {
         fprintf(stderr, ">>> [PARSER] Failed to parse JSON configuration.\n");
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        MeasureJob_t *job = calloc(1, sizeof(MeasureJob_t));
+        if (!job) {
+            free_desired_psd(&cfgs[i]);
+            continue;
+        }
+        job->desired = cfgs[i];     // Takes ownership of the strings
+        find_params_psd(job->desired, &job->hack, &job->psd, &job->rb);
+        print_desired(&job->desired, &job->psd);
+
+        // Window and FFT planning happen here, not in the acquisition loop
+        job->plan = psd_plan_get(&job->psd);
+        if (!job->plan) {
+            fprintf(stderr, ">>> [PSD] Could not prepare plan, dropping job.\n");
+            free_job(job);
+            continue;
+        }
+
+        if (cq_push(&job_queue, job) != 0) {
+            fprintf(stderr, ">>> [QUEUE] Out of memory, dropping job.\n");
+            free_job(job);
+        }
+    }
+    free(cfgs);
+    trace_end("parse_command");
+    printf(">>> [QUEUE] %d job(s) queued, %zu pending.\n", n, cq_count(&job_queue));
+}
+
+/**
+ * Retunes and starts streaming for a job. Returns 0 if RX is running.
+ */
+static int capture_start(MeasureJob_t *job) {
+    if (device == NULL) return -1;
+
+    rb_init(&rb, job->rb.rb_size);
+    stop_streaming = false;
+    atomic_store(&first_sample_ns, 0);
+
+    job->t_cycle_ns = lat_now_ns();
+    trace_begin("retune");
+    hackrf_apply_cfg(device, &job->hack);
+    trace_end("retune");
+    lat_record_since(LAT_RETUNE, job->t_cycle_ns);
+
+    // --- START ACQ TIMER ---
+    job->t_start_acq = get_time_ms();
+    job->t_rx_ns = lat_now_ns();
+
+    if (hackrf_start_rx(device, rx_callback, NULL) != HACKRF_SUCCESS) {
+        rb_free(&rb);
+        return -1;
     }
+    // Closed in capture_finish; the DSP of the previous job nests inside it
+    trace_begin("capture");
+    return 0;
+}
+
+/**
+ * Waits for the ring buffer to fill, stops RX and copies the samples out,
+ * so the next job can start streaming while this one is processed.
+ */
+static int capture_finish(MeasureJob_t *job) {
+    int safety_timeout = 500; 
+    while ((rb_available(&rb) < job->rb.total_bytes) && (safety_timeout > 0)) {
+        usleep(10000); 
+        safety_timeout--;
+    }
+
+    stop_streaming = true;
+    hackrf_stop_rx(device);
+    trace_end("capture");
+
+    // --- STOP ACQ TIMER ---
+    job->t_end_acq = get_time_ms();
+
+    int rc = -1;
+    if (safety_timeout > 0) {
+        uint64_t first = atomic_load(&first_sample_ns);
+        if (first >= job->t_rx_ns) {
+            lat_record(LAT_FIRST_SAMPLE, first - job->t_rx_ns);
+            lat_record_since(LAT_FILL, first);
+        }
+        job->samples = malloc(job->rb.total_bytes);
+        if (job->samples) {
+            rb_read(&rb, job->samples, job->rb.total_bytes);
+            rc = 0;
+        }
+    }
+    rb_free(&rb); 
+    return rc;
+}
+
+static void process_job(MeasureJob_t *job) {
+    // --- START DSP TIMER ---
+    double t_start_dsp = get_time_ms();
+    trace_begin("dsp");
+
+    uint64_t t0 = lat_now_ns();
+    trace_begin("load_iq");
+    signal_iq_t* sig = load_iq_from_buffer(job->samples, job->rb.total_bytes);
+    trace_end("load_iq");
+    lat_record_since(LAT_LOAD_IQ, t0);
+    double* psd = malloc(job->psd.nperseg * sizeof(double));
+    PsdAxis_t axis = {0};
+
+    if (psd && sig) {
+        // 1) PSD (shift, scaling and unit conversion fused in one pass)
+        int rc = execute_welch_psd_plan(sig, job->plan, psd_parse_unit(job->desired.scale),
+                                        &axis, NULL, psd);
+        if (rc != 0) {
+            fprintf(stderr, ">>> [PSD] Welch failed for %" PRIu64 " Hz (nperseg %d, decimation %d), dropping job.\n",
+                    job->desired.center_freq, job->psd.nperseg, job->psd.decimation);
+            goto done;
+        }
+        PsdTiming_t tm;
+        psd_last_timing(&tm);
+        lat_record(LAT_FFT, tm.ddc_ns + tm.accumulate_ns);
+        lat_record(LAT_SCALE, tm.output_ns);
+
+        // 2) Publicar PSD
+        trace_begin("publish");
+        publish_results(job, &axis, psd, job->psd.nperseg);
+        trace_end("publish");
+
+        // --- STOP DSP TIMER ---
+        double t_end_dsp = get_time_ms();
+
+        // --- LOG METRICS (queued; the writer thread does the I/O) ---
+        const DesiredCfg_t *cfg = &job->desired;
+        MetricsRecord_t rec = {
+            .timestamp = time(NULL),
+            .acq_time_ms = job->t_end_acq - job->t_start_acq,
+            .dsp_time_ms = t_end_dsp - t_start_dsp,
+            .center_freq = cfg->center_freq,
+            .rbw = cfg->rbw,
+            .sample_rate = cfg->sample_rate,
+            .span = cfg->span,
+            .overlap = cfg->overlap,
+            .window_type = cfg->window_type,
+            .lna_gain = cfg->lna_gain,
+            .vga_gain = cfg->vga_gain,
+            .amp_enabled = cfg->amp_enabled ? 1 : 0,
+            .psd_bins = job->psd.nperseg,
+        };
+        snprintf(rec.scale, sizeof(rec.scale), "%s", cfg->scale ? cfg->scale : "dBm");
+        t0 = lat_now_ns();
+        metrics_log_push(&rec);
+        lat_record_since(LAT_LOG, t0);
+        lat_record_since(LAT_CYCLE, job->t_cycle_ns);
+    }
+
+done:
+    if (psd) free(psd);
+    free_signal_iq(sig);
+    trace_end("dsp");
+}
+
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    stats_dump_requested = 1;
+}
+
+static void publish_stats(void) {
+    char *json = lat_stats_json();
+    if (!json) return;
+    zpub_publish_owned(publisher, LAT_STATS_TOPIC, NULL, 0, json, strlen(json), zpub_free_default, NULL);
+}
+
+// =========================================================
+// REPLAY BENCHMARK (--bench-e2e)
+// =========================================================
+// Streams recorded or synthetic CS8 through rx_callback at a paced rate
+// and runs every 1 s block through process_job (ring buffer, Welch,
+// scaling, serialization, ZMQ publish). The ring holds two blocks, so a
+// rate is sustainable only if the DSP keeps up with the stream.
+
+#define REPLAY_START_RATE     1e6
+#define REPLAY_MAX_RATE       100e6
+#define REPLAY_DURATION_S     5.0
+#define REPLAY_BISECT_STEPS   4
+#define REPLAY_SYNTH_XFERS    64      // Synthetic loop length, in transfers
+#define REPLAY_MAX_LIST       16
+
+typedef struct {
+    bool sustained;
+    int nperseg;
+    int blocks;
+    uint64_t dropped_bytes;
+    uint64_t late_transfers;
+    double p50_ms, p99_ms, p999_ms, max_ms;
+} ReplayTrial_t;
+
+static int replay_sink(const uint8_t *buf, size_t len, void *ctx) {
+    (void)ctx;
+    hackrf_transfer t = { .buffer = (uint8_t*)buf, .buffer_length = (int)len, .valid_length = (int)len };
+    return rx_callback(&t);
+}
+
+static int replay_trial(const int8_t *data, size_t len, int rbw, double overlap,
+                        const char *window, const char *format, double rate,
+                        double duration_s, ReplayTrial_t *out) {
+    char cfg_json[384];
+    snprintf(cfg_json, sizeof(cfg_json),
+             "{\"center_freq_hz\":98000000,\"sample_rate_hz\":%.0f,\"span\":%.0f,"
+             "\"rbw_hz\":%d,\"overlap\":%g,\"window\":\"%s\",\"scale\":\"dBm\","
+             "\"output_format\":\"%s\",\"request_id\":\"bench_e2e\"}",
+             rate, rate, rbw, overlap, window, format);
+
+    MeasureJob_t job = {0};
+    if (parse_psd_config(cfg_json, &job.desired) != 0) return -1;
+    find_params_psd(job.desired, &job.hack, &job.psd, &job.rb);
+    job.plan = psd_plan_get(&job.psd);
+    if (!job.plan) {
+        free_desired_psd(&job.desired);
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->nperseg = job.psd.nperseg;
+    lat_reset();
+    rb_init(&rb, job.rb.rb_size);
+    stop_streaming = false;
+    atomic_store(&rx_dropped_bytes, 0);
+    atomic_store(&first_sample_ns, 0);
+
+    replay_t src;
+    if (replay_start(&src, data, len, rate, replay_sink, NULL) != 0) {
+        rb_free(&rb);
+        free_desired_psd(&job.desired);
+        psd_plan_release(job.plan);
+        return -1;
+    }
+
+    uint64_t t_end = lat_now_ns() + (uint64_t)(duration_s * 1e9);
+    while (lat_now_ns() < t_end && atomic_load(&rx_dropped_bytes) == 0) {
+        if (rb_available(&rb) < job.rb.total_bytes) {
+            usleep(200);
+            continue;
+        }
+        // Latency runs from "block complete in the ring" to "published"
+        job.t_cycle_ns = lat_now_ns();
+        job.samples = malloc(job.rb.total_bytes);
+        if (!job.samples) break;
+        rb_read(&rb, job.samples, job.rb.total_bytes);
+        job.t_start_acq = job.t_end_acq = get_time_ms();
+        process_job(&job);
+        free(job.samples);
+        job.samples = NULL;
+        out->blocks++;
+    }
+
+    stop_streaming = true;
+    replay_stop(&src);
+    rb_free(&rb);
+
+    out->dropped_bytes = atomic_load(&rx_dropped_bytes);
+    out->late_transfers = atomic_load(&src.late);
+    uint64_t transfers = atomic_load(&src.transfers);
+    // Enough blocks, no overrun, and the pacer itself held the rate
+    out->sustained = out->dropped_bytes == 0
+                  && out->blocks >= (int)duration_s - 1
+                  && out->late_transfers * 100 <= transfers;
+    out->p50_ms = lat_percentile(LAT_CYCLE, 0.50) / 1e6;
+    out->p99_ms = lat_percentile(LAT_CYCLE, 0.99) / 1e6;
+    out->p999_ms = lat_percentile(LAT_CYCLE, 0.999) / 1e6;
+    out->max_ms = lat_percentile(LAT_CYCLE, 1.0) / 1e6;
+
+    fprintf(stderr, "[E2E] rbw=%d ov=%.2f %s %s @ %.2f MS/s: %s (%d blocks, %" PRIu64 " B dropped, p99 %.1f ms)\n",
+            rbw, overlap, window, format, rate / 1e6, out->sustained ? "OK" : "FAIL",
+            out->blocks, out->dropped_bytes, out->p99_ms);
+
+    free_desired_psd(&job.desired);
+    psd_plan_release(job.plan);
+    return 0;
+}
+
+static int split_list(char *arg, char **items) {
+    int n = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(arg, ",", &save); tok && n < REPLAY_MAX_LIST; tok = strtok_r(NULL, ",", &save)) {
+        items[n++] = tok;
+    }
+    return n;
 }
 
+static int bench_e2e_main(int argc, char **argv) {
+    const char *input = NULL;
+    const char *out_path = "bench_e2e.json";
+    double duration_s = REPLAY_DURATION_S;
+    double max_rate = REPLAY_MAX_RATE;
+    char rbw_arg[128] = "10000", overlap_arg[128] = "0.5", window_arg[128] = "hann", format_arg[64] = "json";
+
+    for (int i = 1; i < argc; i++) {
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) {
+            fprintf(stderr, "[E2E] Missing value for %s\n", argv[i]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--input") == 0) input = val;
+        else if (strcmp(argv[i], "--out") == 0) out_path = val;
+        else if (strcmp(argv[i], "--duration") == 0) duration_s = atof(val);
+        else if (strcmp(argv[i], "--max-rate") == 0) max_rate = atof(val);
+        else if (strcmp(argv[i], "--rbw") == 0) snprintf(rbw_arg, sizeof(rbw_arg), "%s", val);
+        else if (strcmp(argv[i], "--overlap") == 0) snprintf(overlap_arg, sizeof(overlap_arg), "%s", val);
+        else if (strcmp(argv[i], "--window") == 0) snprintf(window_arg, sizeof(window_arg), "%s", val);
+        else if (strcmp(argv[i], "--format") == 0) snprintf(format_arg, sizeof(format_arg), "%s", val);
+        else {
+            fprintf(stderr,
+                    "Usage: rf_metrics --bench-e2e [--input Samples/N] [--rbw 1000,10000] [--overlap 0,0.5]\n"
+                    "       [--window hann,blackman] [--format json|binary] [--duration s] [--max-rate sps]\n"
+                    "       [--out bench_e2e.json]\n");
+            return 2;
+        }
+        i++;
+    }
+    if (duration_s < 3.0) duration_s = 3.0;     // At least two 1 s blocks
+
+    size_t len = 0;
+    int8_t *data = input ? replay_load_cs8(input, &len) : replay_synth_cs8(REPLAY_SYNTH_XFERS, &len);
+    if (!data) return 1;
+
+    publisher = zpub_init_ex(PUB_SNDHWM, false);
+    if (!publisher) {
+        free(data);
+        return 1;
+    }
+
+    char *rbws[REPLAY_MAX_LIST], *overlaps[REPLAY_MAX_LIST], *windows[REPLAY_MAX_LIST], *formats[REPLAY_MAX_LIST];
+    int n_rbw = split_list(rbw_arg, rbws);
+    int n_ov = split_list(overlap_arg, overlaps);
+    int n_win = split_list(window_arg, windows);
+    int n_fmt = split_list(format_arg, formats);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "input", input ? input : "synthetic");
+    cJSON_AddNumberToObject(root, "duration_s", duration_s);
+    cJSON *results = cJSON_AddArrayToObject(root, "results");
+
+    for (int a = 0; a < n_rbw; a++)
+    for (int b = 0; b < n_ov; b++)
+    for (int c = 0; c < n_win; c++)
+    for (int d = 0; d < n_fmt; d++) {
+        int rbw = atoi(rbws[a]);
+        double overlap = atof(overlaps[b]);
+        ReplayTrial_t trial, best = {0};
+        double good = 0.0, bad = 0.0;
+
+        // Double until the stream overruns, then bisect the last interval
+        for (double rate = REPLAY_START_RATE; rate <= max_rate; rate *= 2.0) {
+            if (replay_trial(data, len, rbw, overlap, windows[c], formats[d], rate, duration_s, &trial) != 0) break;
+            if (!trial.sustained) { bad = rate; break; }
+            good = rate;
+            best = trial;
+        }
+        for (int s = 0; good > 0.0 && bad > 0.0 && s < REPLAY_BISECT_STEPS; s++) {
+            double mid = 0.5 * (good + bad);
+            if (replay_trial(data, len, rbw, overlap, windows[c], formats[d], mid, duration_s, &trial) != 0) break;
+            if (trial.sustained) { good = mid; best = trial; }
+            else bad = mid;
+        }
+
+        cJSON *r = cJSON_CreateObject();
+        cJSON_AddNumberToObject(r, "rbw_hz", rbw);
+        cJSON_AddNumberToObject(r, "overlap", overlap);
+        cJSON_AddStringToObject(r, "window", windows[c]);
+        cJSON_AddStringToObject(r, "format", formats[d]);
+        cJSON_AddNumberToObject(r, "max_rate_sps", good);
+        cJSON_AddBoolToObject(r, "rate_capped", bad == 0.0 && good > 0.0);
+        cJSON_AddNumberToObject(r, "nperseg", best.nperseg);
+        cJSON_AddNumberToObject(r, "blocks", best.blocks);
+        cJSON *lat = cJSON_AddObjectToObject(r, "latency_ms");
+        cJSON_AddNumberToObject(lat, "p50", best.p50_ms);
+        cJSON_AddNumberToObject(lat, "p99", best.p99_ms);
+        cJSON_AddNumberToObject(lat, "p999", best.p999_ms);
+        cJSON_AddNumberToObject(lat, "max", best.max_ms);
+        cJSON_AddItemToArray(results, r);
+    }
+
+    char *text = cJSON_Print(root);
+    FILE *fp = fopen(out_path, "w");
+    if (fp && text) {
+        fputs(text, fp);
+        fputc('\n', fp);
+        fclose(fp);
+        printf("[E2E] Results written to %s\n", out_path);
+    } else {
+        fprintf(stderr, "[E2E] Cannot write %s\n", out_path);
+        if (fp) fclose(fp);
+    }
+    free(text);
+    cJSON_Delete(root);
+    zpub_close(publisher);
+    free(data);
+    return 0;
+}
 
 // =========================================================
 // MAIN ORCHESTRATION
 // =========================================================
 
-int main() {
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench-e2e") == 0) {
+        return bench_e2e_main(argc - 1, argv + 1);
+    }
 
     // 0. Bandera para habilitar / deshabilitar demodulación FM
     //    (true -> demodular y guardar WAV, false -> solo PSD)
     bool enable_demodulation = false;
     
-    // 1. Metrics Init
-    init_csv_filename();
-    get_cpu_load(); // Prime the CPU delta calculation
+    // 1. Metrics Init (background writer, rotated + gzipped CSV)
+    MetricsLogCfg_t metrics_cfg = { .folder = CSV_FOLDER, .max_file_bytes = 0, .compress = true };
+    if (metrics_log_start(&metrics_cfg) != 0) {
+        fprintf(stderr, "[METRICS] Warning: metrics logging disabled.\n");
+    }
+
+    // SIGUSR1: dump the stage latency table to stdout
+    struct sigaction sa = {0};
+    sa.sa_handler = on_sigusr1;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+
+    // RF_TRACE=<file.json>: Chrome trace of capture / DSP / publish
+    if (trace_enabled()) trace_thread_name("main");
 
     // 2. ZMQ & SDR Init
+    if (cq_init(&job_queue, 64) != 0) return 1;
+
     zsub_t *sub = zsub_init("acquire", handle_psd_message);
     if (!sub) return 1;
     zsub_start(sub);
 
-    publisher = zpub_init();
+    const char *hwm_env = getenv("RF_PUB_HWM");
+    const char *conflate_env = getenv("RF_PUB_CONFLATE");
+    publisher = zpub_init_ex(hwm_env ? atoi(hwm_env) : PUB_SNDHWM,
+                             conflate_env && atoi(conflate_env) != 0);
     if (!publisher) return 1;
 
     if (hackrf_init() != HACKRF_SUCCESS) return 1;
@@ -356,106 +784,60 @@ int main() {
 
 
     // 3. Continuous Loop
-    bool needs_recovery = false; 
+    //    Pipelined: job N+1 is retuned and streaming while job N runs its DSP.
+    MeasureJob_t *captured = NULL;
+    uint64_t idle_since = 0;
+    time_t last_stats = time(NULL);
 
     while (1) {
-        // Variables for timing
-        double t_start_acq = 0, t_end_acq = 0;
-        double t_start_dsp = 0, t_end_dsp = 0;
-
-        // A. Wait for ZMQ Command
-        if (!config_received) {
-            usleep(10000); 
-            continue;
+        if (stats_dump_requested) {
+            stats_dump_requested = 0;
+            lat_dump(stdout);
         }
-
-        if (device == NULL) {
-            needs_recovery = true;
-            goto error_handler;
+        if (time(NULL) - last_stats >= STATS_PERIOD_S) {
+            publish_stats();
+            last_stats = time(NULL);
         }
 
-        // B. Setup Acquisition
-        rb_init(&rb, rb_cfg.rb_size);
-        stop_streaming = false;
-
-        hackrf_apply_cfg(device, &hack_cfg);
-        
-        // --- START ACQ TIMER ---
-        t_start_acq = get_time_ms();
-
-        hackrf_start_rx(device, rx_callback, NULL);
-
-        // C. Wait for Buffer Fill
-        int safety_timeout = 500; 
-        while ((rb_available(&rb) < rb_cfg.total_bytes) && (safety_timeout > 0)) {
-            usleep(10000); 
-            safety_timeout--;
+        // A. Next command (wait only when nothing is left to process)
+        uint64_t t_pop = lat_now_ns();
+        MeasureJob_t *job = cq_pop(&job_queue, captured ? 0 : 100);
+        if (!job && !captured && idle_since == 0) idle_since = t_pop;
+        if (job) {
+            lat_record_since(LAT_WAIT_CMD, idle_since ? idle_since : t_pop);
+            idle_since = 0;
         }
 
-        stop_streaming = true;
-        hackrf_stop_rx(device);
-
-        // --- STOP ACQ TIMER ---
-        t_end_acq = get_time_ms();
-
-        if (safety_timeout <= 0) {
-            needs_recovery = true;
-            goto error_handler;
+        // B. Retune + start streaming for the next job
+        bool streaming = false;
+        if (job) {
+            if (device == NULL) recover_hackrf();
+            streaming = (capture_start(job) == 0);
         }
 
-        // D. DSP Processing
-        int8_t* linear_buffer = malloc(rb_cfg.total_bytes);
-        if (linear_buffer) {
-            rb_read(&rb, linear_buffer, rb_cfg.total_bytes);
-            
-            // --- START DSP TIMER ---
-            t_start_dsp = get_time_ms();
-
-            signal_iq_t* sig = load_iq_from_buffer(linear_buffer, rb_cfg.total_bytes);
-            double* freq = malloc(psd_cfg.nperseg * sizeof(double));
-            double* psd = malloc(psd_cfg.nperseg * sizeof(double));
-
-            if (freq && psd && sig) {
-                // 1) PSD
-                execute_welch_psd(sig, &psd_cfg, freq, psd);
-                scale_psd(psd, psd_cfg.nperseg, desired_config.scale);
-
-                // 2) Publicar PSD
-                publish_results(freq, psd, psd_cfg.nperseg);
-
-
-                // --- STOP DSP TIMER (incluye PSD + demod) ---
-                t_end_dsp = get_time_ms();
-
-                // --- LOG METRICS ---
-                SystemMetrics_t metrics;
-                metrics.acq_time_ms = t_end_acq - t_start_acq;
-                metrics.dsp_time_ms = t_end_dsp - t_start_dsp;
-                collect_system_metrics(&metrics);
-                
-                log_to_csv(&metrics, &desired_config, psd_cfg.nperseg);
-                printf("[METRICS] Logged cycle to CSV.\n");
-            }
-
-            free(linear_buffer);
-            if (freq) free(freq);
-            if (psd) free(psd);
-            free_signal_iq(sig);
+        // C. DSP of the previous capture overlaps with the acquisition
+        if (captured) {
+            process_job(captured);
+            free_job(captured);
+            captured = NULL;
         }
 
-        rb_free(&rb); 
-        config_received = false; 
-        continue; 
+        if (!job) continue;
 
-        // E. Error Handler
-        error_handler:
-        rb_free(&rb); 
-        if (needs_recovery) {
-            recover_hackrf();
-            needs_recovery = false;
+        // D. Collect the samples of the new job
+        if (streaming && capture_finish(job) == 0) {
+            captured = job;
+            continue;
+        }
+
+        // E. Error Handler: reset the radio and retry the job once, in place
+        recover_hackrf();
+        if (capture_start(job) == 0 && capture_finish(job) == 0) {
+            captured = job;
+            continue;
         }
-        config_received = false;
-        printf("[SYSTEM] Cycle Aborted.\n");
+        printf("[SYSTEM] Cycle Aborted (%s).\n", job->desired.request_id ? job->desired.request_id : "-");
+        free_job(job);
     }
 
     return 0;
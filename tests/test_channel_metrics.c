@@ -0,0 +1,156 @@
+/**
+ * @file tests/test_channel_metrics.c
+ * @brief Regression test for chan_metrics_compute on broadcast-width channels
+ *
+ * Builds a 20 MHz, 32768-bin PSD (about 610 Hz/bin) with Welch-like noise
+ * (16 averaged periodograms), one flat 6 MHz channel at +20 dB and 200 kHz
+ * FM-like channels at +10/+20/+30/+40 dB, then checks that
+ *   - the noise floor built inside chan_metrics_compute stays on the noise
+ *     instead of following the channels, so SNR tracks the injected level;
+ *   - presence, with the plain threshold and with per-channel CFAR, marks the
+ *     occupied channels and leaves the empty ones.
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "channel_metrics.h"
+
+#define TEST_BINS       32768
+#define TEST_SPAN_HZ    20e6
+#define TEST_AVERAGES   16
+#define TEST_NOISE      1e-12
+
+typedef struct {
+    double center;
+    double bw;
+    double snr_db;      // Injected level above the noise; <= -100 for an empty channel
+    int flat;           // 1: flat across the channel, 0: FM-like bell
+} test_chan_t;
+
+// Channel 0 is the 6 MHz one; the FM-only table below leaves it out
+static const test_chan_t chans[] = {
+    { 10.0e6, 6e6,   20.0, 1 },
+    {  2.0e6, 200e3, 10.0, 0 },
+    {  2.2e6, 200e3, 20.0, 0 },
+    {  2.6e6, 200e3, 30.0, 0 },
+    {  3.0e6, 200e3, 40.0, 0 },
+    { 16.0e6, 200e3, 30.0, 1 },
+    {  1.0e6, 200e3, -200.0, 1 },
+    { 18.0e6, 6e6 / 4, -200.0, 1 },
+};
+#define N_CHANS ((int)(sizeof(chans) / sizeof(chans[0])))
+
+static uint32_t rng_state = 0x2545F491u;
+
+static double rng_uniform(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return ((double)rng_state + 0.5) / 4294967296.0;
+}
+
+// Mean of TEST_AVERAGES exponential draws: the spread of a Welch bin
+static double welch_spread(void) {
+    double s = 0.0;
+    for (int k = 0; k < TEST_AVERAGES; k++) s -= log(rng_uniform());
+    return s / TEST_AVERAGES;
+}
+
+static void make_psd(double* psd, double* f) {
+    double df = TEST_SPAN_HZ / TEST_BINS;
+    for (int i = 0; i < TEST_BINS; i++) {
+        f[i] = i * df;
+        double level = TEST_NOISE;
+        for (int c = 0; c < N_CHANS; c++) {
+            double x = (f[i] - chans[c].center) / (0.5 * chans[c].bw);
+            if (chans[c].snr_db <= -100.0 || fabs(x) >= 1.0) continue;
+            double shape = chans[c].flat ? 1.0 : exp(-2.0 * x * x);
+            level += TEST_NOISE * pow(10.0, chans[c].snr_db / 10.0) * shape;
+        }
+        psd[i] = level * welch_spread();
+    }
+}
+
+// Runs chan_metrics_compute over chans[first..last) and checks every SNR
+static int check_table(const double* psd, const double* f, int first, int last, const char* name) {
+    int n = last - first;
+    double centers[N_CHANS], bws[N_CHANS];
+    freq_range_t ranges[N_CHANS];
+    for (int c = 0; c < n; c++) {
+        centers[c] = chans[first + c].center;
+        bws[c] = chans[first + c].bw;
+    }
+    freq_grid_t grid = freq_grid_from_array(f, TEST_BINS);
+    freq_grid_channel_table(&grid, centers, bws, n, ranges);
+
+    chan_metrics_t m;
+    if (chan_metrics_alloc(&m, n) != 0) return 1;
+    if (chan_metrics_compute(psd, NULL, &grid, ranges, n, -200.0, NULL, &m) != 0) {
+        fprintf(stderr, "[TEST] chan_metrics_compute failed (%s)\n", name);
+        chan_metrics_free(&m);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int c = 0; c < n; c++) {
+        const test_chan_t* ch = &chans[first + c];
+        double snr = m.snr_db[c];
+        // The peak rides the Welch spread of (signal + noise): allow -1 dB .. +4 dB around the injected level
+        int ok;
+        if (ch->snr_db <= -100.0) {
+            ok = snr < 4.5;
+        } else {
+            ok = snr > ch->snr_db - 1.0 && snr < ch->snr_db + 4.0;
+        }
+        printf("[TEST] %s: %6.2f MHz %5.0f kHz injected %6.1f dB: SNR %6.2f dB %s\n",
+               name, ch->center / 1e6, ch->bw / 1e3, ch->snr_db, snr, ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+
+    // Presence: plain threshold 10 dB above the noise, then CFAR alone (no absolute floor)
+    const cfar_cfg_t cfar = CFAR_CFG_DEFAULT;
+    const double threshold_db = 10.0 * log10(TEST_NOISE) + 10.0 - 1.0;
+    for (int pass = 0; pass < 2; pass++) {
+        int rc = pass == 0
+            ? chan_metrics_compute(psd, NULL, &grid, ranges, n, threshold_db, NULL, &m)
+            : chan_metrics_compute(psd, NULL, &grid, ranges, n, -200.0, &cfar, &m);
+        if (rc != 0) {
+            fprintf(stderr, "[TEST] chan_metrics_compute failed (%s, presence)\n", name);
+            failures++;
+            continue;
+        }
+        for (int c = 0; c < n; c++) {
+            const test_chan_t* ch = &chans[first + c];
+            int expected = ch->snr_db > -100.0;
+            int ok = m.presence[c] == expected;
+            printf("[TEST] %s: %6.2f MHz %5.0f kHz %s: presence %d (%d CFAR bins) %s\n",
+                   name, ch->center / 1e6, ch->bw / 1e3, pass == 0 ? "threshold" : "CFAR     ",
+                   m.presence[c], m.detections[c], ok ? "ok" : "FAIL");
+            failures += !ok;
+        }
+    }
+
+    chan_metrics_free(&m);
+    return failures;
+}
+
+int main(void) {
+    double* psd = malloc(TEST_BINS * sizeof(double));
+    double* f = malloc(TEST_BINS * sizeof(double));
+    if (!psd || !f) return 1;
+    make_psd(psd, f);
+
+    int failures = check_table(psd, f, 0, N_CHANS, "all channels");
+    failures += check_table(psd, f, 1, N_CHANS, "FM-width only");
+
+    chan_metrics_pool_shutdown();
+    free(psd);
+    free(f);
+    printf("[TEST] %s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
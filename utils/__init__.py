@@ -6,9 +6,13 @@
 from .io_util import atomic_write_bytes, get_persist_var, modify_persist, CronHandler, ElapsedTimer
 from .request_util import RequestClient, ZmqPub, ZmqSub
 from .welch_util import WelchEstimator, CampaignHackRF
+from .psd_wire import decode_psd, PsdWireDecoder, ZmqPsdSub
+from .psd_shm import PsdShmReader, ZmqShmSub
 
 __all__ = ["atomic_write_bytes", "RequestClient", "get_persist_var", "modify_persist", 
-           "ZmqPub", "ZmqSub", "CronHandler", "WelchEstimator", "CampaignHackRF", "ElapsedTimer"]
+           "ZmqPub", "ZmqSub", "CronHandler", "WelchEstimator", "CampaignHackRF", "ElapsedTimer",
+           "decode_psd", "PsdWireDecoder", "ZmqPsdSub",
+           "PsdShmReader", "ZmqShmSub"]
 
 
 """
@@ -0,0 +1,185 @@
+"""
+@file utils/psd_shm.py
+@brief Zero-copy reader for the shared-memory PSD ring (see main_c/libs/psd_shm.h).
+"""
+
+import mmap
+import os
+import struct
+import logging
+import numpy as np
+import zmq
+import zmq.asyncio
+
+PSD_SHM_PATH = "/dev/shm/psd_results"
+PSD_SHM_TOPIC = "psd_shm"
+
+_RING = struct.Struct("<4sHHIII4xQ")          # magic .. frames
+_SLOT = struct.Struct("<QddIB3xQQQ8x64s")     # seq .. request_id
+_RING_FRAMES_OFF = 24
+_NOTIFY = struct.Struct("<IQ")                # slot, frame
+_UNITS = {0: "density", 1: "dBm", 2: "dBuV", 3: "dBmV", 4: "W", 5: "V"}
+
+
+class TornRead(Exception):
+    """The writer reused the slot while it was being read."""
+
+
+class PsdShmReader:
+    """
+    Maps the ring read-only. view() returns numpy views straight into the
+    shared memory; call still_valid() after using a view (or use read(),
+    which copies and validates) because the writer recycles slots.
+    """
+
+    def __init__(self, path: str = PSD_SHM_PATH):
+        self.path = path
+        fd = os.open(path, os.O_RDONLY)
+        try:
+            st = os.fstat(fd)
+            self._ident = (st.st_dev, st.st_ino)
+            self._mm = mmap.mmap(fd, st.st_size, prot=mmap.PROT_READ)
+        finally:
+            os.close(fd)
+
+        (magic, version, hdr_len, n_slots, max_bins,
+         stride, _frames) = _RING.unpack_from(self._mm, 0)
+        if magic != b"PSDR" or version != 1:
+            raise ValueError(f"Not a PSD ring (magic={magic!r}, version={version})")
+        self.header_len = hdr_len
+        self.n_slots = n_slots
+        self.max_bins = max_bins
+        self.stride = stride
+        self._buf = memoryview(self._mm)
+
+    def _slot_off(self, idx: int) -> int:
+        if not 0 <= idx < self.n_slots:
+            raise IndexError(f"Slot {idx} out of range")
+        return self.header_len + idx * self.stride
+
+    def _seq(self, idx: int) -> int:
+        return struct.unpack_from("<Q", self._mm, self._slot_off(idx))[0]
+
+    def frames_written(self) -> int:
+        return struct.unpack_from("<Q", self._mm, _RING_FRAMES_OFF)[0]
+
+    def replaced(self) -> bool:
+        """True once the writer has unlinked or re-created the ring at path."""
+        try:
+            st = os.stat(self.path)
+        except FileNotFoundError:
+            return True
+        return (st.st_dev, st.st_ino) != self._ident
+
+    def view(self, idx: int):
+        """Returns (seq, meta, Pxx view). Raises TornRead if a write is in progress."""
+        off = self._slot_off(idx)
+        (seq, start_hz, step_hz, bins, units, ts, chash,
+         frame, rid) = _SLOT.unpack_from(self._mm, off)
+        if seq & 1:
+            raise TornRead(f"Slot {idx} is being written")
+        bins = min(bins, self.max_bins)
+        pxx = np.frombuffer(self._buf, dtype="<f4", count=bins, offset=off + 128)
+        meta = {
+            "start_freq_hz": start_hz,
+            "step_hz": step_hz,
+            "end_freq_hz": start_hz + step_hz * (bins - 1),
+            "bin_count": bins,
+            "units": _UNITS.get(units, str(units)),
+            "timestamp_ns": ts,
+            "config_hash": chash,
+            "frame": frame,
+            "request_id": rid.split(b"\0", 1)[0].decode("utf-8", "replace") or None,
+        }
+        return seq, meta, pxx
+
+    def still_valid(self, idx: int, seq: int) -> bool:
+        return self._seq(idx) == seq
+
+    def read(self, idx: int, retries: int = 3) -> dict:
+        """Copies one slot, retrying torn reads."""
+        for _ in range(retries):
+            try:
+                seq, meta, pxx = self.view(idx)
+                data = pxx.copy()
+                if self.still_valid(idx, seq):
+                    meta["Pxx"] = data
+                    return meta
+            except TornRead:
+                pass
+        raise TornRead(f"Slot {idx} kept changing")
+
+    def close(self):
+        self._buf.release()
+        self._mm.close()
+
+
+class ZmqShmSub:
+    """
+    Waits for slot notifications and returns the decoded slot.
+
+    The writer re-creates the ring on restart, which leaves an open mapping
+    pointing at the old, unlinked object. The ring is re-opened when its
+    inode changes, when the announced frame numbers go backwards, or when a
+    slot holds an older frame than the notification announced.
+    """
+
+    def __init__(self, addr, path: str = PSD_SHM_PATH, log=logging.getLogger(__name__)):
+        self._log = log
+        self._path = path
+        self.reader = None
+        self._last_frame = -1
+        self.context = zmq.asyncio.Context()
+        self.socket = self.context.socket(zmq.SUB)
+        self.socket.connect(addr)
+        self.socket.subscribe(PSD_SHM_TOPIC.encode("utf-8"))
+
+        self._log.info(f"ZmqShmSub initialized at {addr} for {path}")
+
+    def _reopen(self, why: str):
+        if self.reader is not None:
+            self._log.info(f"[ZmqShmSub] Re-opening {self._path}: {why}")
+            self.reader.close()
+            self.reader = None
+        # The ring is created lazily by the first shm result
+        self.reader = PsdShmReader(self._path)
+
+    def _read(self, idx: int, frame: int) -> dict:
+        if self.reader is None:
+            self._reopen("first notification")
+        elif self.reader.replaced():
+            self._reopen("ring re-created")
+        elif frame < self._last_frame:
+            self._reopen(f"frame number went back to {frame}")
+
+        res = self.reader.read(idx)
+        if res["frame"] < frame:
+            # Old mapping that survived a writer restart between stat and read
+            self._reopen(f"slot {idx} holds frame {res['frame']}, announced {frame}")
+            res = self.reader.read(idx)
+        if res["frame"] != frame:
+            raise TornRead(f"Slot {idx} holds frame {res['frame']}, announced {frame}")
+        return res
+
+    async def wait_msg(self):
+        while True:
+            frames = await self.socket.recv_multipart()
+            if len(frames) == 1:
+                # Conflating publisher: "topic <u32 slot><u64 frame>"
+                frames = [frames[0][:len(PSD_SHM_TOPIC)], frames[0][len(PSD_SHM_TOPIC) + 1:]]
+            if len(frames) != 2 or len(frames[1]) != _NOTIFY.size:
+                continue
+            idx, frame = _NOTIFY.unpack(frames[1])
+            try:
+                res = self._read(idx, frame)
+                self._last_frame = frame
+                return res
+            except (TornRead, OSError, ValueError, IndexError) as e:
+                self._last_frame = frame
+                self._log.warning(f"[ZmqShmSub] Dropped slot {idx}: {e}")
+
+    def close(self):
+        if self.reader:
+            self.reader.close()
+        self.socket.close()
+        self.context.term()
@@ -0,0 +1,197 @@
+"""
+@file utils/psd_wire.py
+@brief Decoder for the binary PSD result message (see main_c/libs/psd_wire.h).
+"""
+
+import struct
+import numpy as np
+import zmq
+import zmq.asyncio
+import logging
+
+PSD_WIRE_TOPIC = "psd_bin"
+PSD_WIRE_MAGIC = b"PSDB"
+PSD_WIRE_VERSION = 1
+
+# magic, version, header_len, start_hz, step_hz, bins, units, encoding, flags, timestamp_ns, config_hash
+_HEADER = struct.Struct("<4sHHddIBBHQQ")
+
+_QHEADER = struct.Struct("<ffIB3x")
+
+UNITS = {0: "density", 1: "dBm", 2: "dBuV", 3: "dBmV", 4: "W", 5: "V"}
+
+ENC_F32, ENC_Q16, ENC_Q8 = 0, 1, 2
+FLAG_KEYFRAME = 0x0001
+FLAG_CLIPPED = 0x0002
+
+_RICE_ESCAPE = 24
+_RICE_RAW_BITS = 17
+
+
+def _rice_decode(data: bytes, n: int, k: int) -> np.ndarray:
+    """
+    Decode n Rice-coded zigzag residuals (MSB first) into signed ints.
+
+    Vectorised: every bit position p gets the start of the codeword that
+    would follow one starting at p, and the n real starts are found by
+    pointer doubling from bit 0, so the cost is O(bits * log n) in numpy
+    instead of a Python step per bit.
+    """
+    if n == 0:
+        return np.zeros(0, dtype=np.int64)
+    bits = np.unpackbits(np.frombuffer(data, dtype=np.uint8))
+    total = bits.size
+
+    # First zero at or after each position (total = none); slot total is a sink
+    pos = np.arange(total + 1, dtype=np.int64)
+    zero_at = np.where(np.append(bits, 0) == 0, pos, total)
+    zero_at[total] = total
+    next_zero = np.minimum.accumulate(zero_at[::-1])[::-1]
+
+    escape = next_zero - pos >= _RICE_ESCAPE
+    succ = np.where(escape, pos + _RICE_ESCAPE + _RICE_RAW_BITS, next_zero + 1 + k)
+    succ = np.minimum(succ, total)
+    succ[total] = total
+
+    # starts[i] = succ^i(0), doubling the number of known starts per pass
+    starts = np.zeros(n, dtype=np.int64)
+    jump = succ
+    have = 1
+    while have < n:
+        m = min(have, n - have)
+        starts[have:have + m] = jump[starts[:m]]
+        have += m
+        if have < n:
+            jump = jump[jump]
+
+    last = starts[-1]
+    end = last + _RICE_ESCAPE + _RICE_RAW_BITS if escape[last] else next_zero[last] + 1 + k
+    if last >= total or end > total:
+        raise ValueError("Truncated bitstream")
+
+    padded = np.concatenate([bits, np.zeros(_RICE_RAW_BITS, dtype=np.uint8)]).astype(np.int64)
+
+    def field(at, nbits):
+        v = np.zeros(at.size, dtype=np.int64)
+        for j in range(nbits):
+            v = (v << 1) | padded[at + j]
+        return v
+
+    esc = escape[starts]
+    z = next_zero[starts]
+    u = ((z - starts) << k) | field(z + 1, k)
+    if esc.any():
+        u[esc] = field(starts[esc] + _RICE_ESCAPE, _RICE_RAW_BITS)
+    return (u >> 1) ^ -(u & 1)
+
+
+class PsdWireDecoder:
+    """
+    Stateful decoder: keeps the last codes per config hash so delta frames
+    (no KEYFRAME flag) can be reconstructed. Frames whose reference is
+    missing raise ValueError until the next keyframe arrives.
+    """
+
+    def __init__(self):
+        self._ref = {}   # config_hash -> (seq, codes)
+
+    def decode(self, header: bytes, payload: bytes) -> dict:
+        return decode_psd(header, payload, self._ref)
+
+
+def decode_psd(header: bytes, payload: bytes, ref: dict = None) -> dict:
+    """
+    Decode one binary PSD message (header frame + payload frame).
+    Delta frames need the ref dict kept by PsdWireDecoder.
+    Raises ValueError on a malformed or unsupported message.
+    """
+    if len(header) < _HEADER.size:
+        raise ValueError(f"Header too short ({len(header)} bytes)")
+
+    (magic, version, header_len, start_hz, step_hz, bins,
+     units, encoding, flags, timestamp_ns, config_hash) = _HEADER.unpack_from(header)
+
+    request_id = None
+    if header_len > _HEADER.size and len(header) >= header_len:
+        id_len = header[_HEADER.size]
+        request_id = header[_HEADER.size + 1:_HEADER.size + 1 + id_len].decode("utf-8", "replace")
+
+    if magic != PSD_WIRE_MAGIC:
+        raise ValueError(f"Bad magic {magic!r}")
+    if version != PSD_WIRE_VERSION:
+        raise ValueError(f"Unsupported version {version}")
+
+    max_error_db = 0.0
+    if encoding == ENC_F32:
+        if len(payload) != 4 * bins:
+            raise ValueError(f"Payload has {len(payload)} bytes, expected {4 * bins}")
+        pxx = np.frombuffer(payload, dtype="<f4", count=bins)
+    elif encoding in (ENC_Q16, ENC_Q8):
+        if len(payload) < _QHEADER.size:
+            raise ValueError("Quantized payload too short")
+        step, base, seq, k = _QHEADER.unpack_from(payload)
+        resid = _rice_decode(payload[_QHEADER.size:], bins, k)
+
+        if flags & FLAG_KEYFRAME:
+            codes = np.cumsum(resid)
+        else:
+            prev = ref.get(config_hash) if ref is not None else None
+            if prev is None or prev[0] != seq - 1 or len(prev[1]) != bins:
+                raise ValueError(f"Delta frame {seq} without its reference frame")
+            codes = prev[1] + resid
+
+        if ref is not None:
+            ref[config_hash] = (seq, codes)
+        pxx = base + codes.astype(np.float64) * step
+        max_error_db = step / 2.0
+    else:
+        raise ValueError(f"Unsupported encoding {encoding}")
+
+    return {
+        "start_freq_hz": start_hz,
+        "step_hz": step_hz,
+        "end_freq_hz": start_hz + step_hz * (bins - 1),
+        "bin_count": bins,
+        "units": UNITS.get(units, str(units)),
+        "timestamp_ns": timestamp_ns,
+        "config_hash": config_hash,
+        "request_id": request_id,
+        "max_error_db": max_error_db,       # Not guaranteed for bins when "clipped"
+        "clipped": bool(flags & FLAG_CLIPPED),
+        "keyframe": bool(flags & FLAG_KEYFRAME),
+        "Pxx": pxx,
+    }
+
+
+class ZmqPsdSub:
+    """Async subscriber for the binary PSD topic; returns decoded dicts."""
+
+    def __init__(self, addr, topic: str = PSD_WIRE_TOPIC, log=logging.getLogger(__name__)):
+        self.topic = topic
+        self._log = log
+        self.context = zmq.asyncio.Context()
+        self.socket = self.context.socket(zmq.SUB)
+        self.socket.connect(addr)
+        self.socket.subscribe(self.topic.encode("utf-8"))
+        self.decoder = PsdWireDecoder()
+
+        self._log.info(f"ZmqPsdSub initialized at {addr} with topic {self.topic}")
+
+    async def wait_msg(self):
+        while True:
+            frames = await self.socket.recv_multipart()
+            if len(frames) == 1:
+                # Conflating publisher: "topic header+payload" in one frame
+                topic, _, body = frames[0].partition(b" ")
+                hlen = struct.unpack_from("<H", body, 6)[0] if len(body) >= 8 else 0
+                frames = [topic, body[:hlen], body[hlen:]]
+            if len(frames) != 3 or frames[0].decode("utf-8", "replace") != self.topic:
+                continue
+            try:
+                return self.decoder.decode(frames[1], frames[2])
+            except ValueError as e:
+                self._log.warning(f"[ZmqPsdSub] Dropped frame: {e}")
+
+    def close(self):
+        self.socket.close()
+        self.context.term()
@@ -0,0 +1,100 @@
+"""
+@file utils/psd_wire_check.py
+@brief C -> Python round-trip check of the binary PSD wire format.
+
+Runs bench/psd_wire_dump (the C encoder), decodes every frame with
+psd_wire.PsdWireDecoder and compares it with the trace that was encoded:
+F32 and linear units must match float32 exactly, quantized frames must stay
+within step / 2 (saturated bins excluded), and interleaved configs must get
+delta frames.
+
+Usage: python3 utils/psd_wire_check.py <path to psd_wire_dump> [BINS]
+Exit status 0 when every frame checks out.
+"""
+
+import os
+import struct
+import subprocess
+import sys
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import psd_wire  # noqa: E402  (loaded directly: the package pulls in scipy)
+
+_U32 = struct.Struct("<I")
+
+
+def _frames(blob: bytes):
+    pos = 0
+    while pos < len(blob):
+        parts = []
+        for _ in range(2):
+            (length,) = _U32.unpack_from(blob, pos)
+            parts.append(blob[pos + 4:pos + 4 + length])
+            pos += 4 + length
+        (bins,) = _U32.unpack_from(blob, pos)
+        ref = np.frombuffer(blob, dtype="<f8", count=bins, offset=pos + 4)
+        pos += 4 + 8 * bins
+        yield parts[0], parts[1], ref
+
+
+def check(dump_path: str, bins: int) -> list:
+    blob = subprocess.run([dump_path, str(bins)], check=True, capture_output=True).stdout
+    decoder = psd_wire.PsdWireDecoder()
+    errors = []
+    deltas = {}
+    count = 0
+
+    for idx, (header, payload, ref) in enumerate(_frames(blob)):
+        count += 1
+        try:
+            res = decoder.decode(header, payload)
+        except ValueError as e:
+            errors.append(f"frame {idx}: {e}")
+            continue
+
+        pxx = np.asarray(res["Pxx"], dtype=np.float64)
+        if res["bin_count"] != len(ref) or len(pxx) != len(ref):
+            errors.append(f"frame {idx}: {len(pxx)} bins decoded, {len(ref)} encoded")
+            continue
+        if res["request_id"] not in (None, "wire-a"):
+            errors.append(f"frame {idx}: request id {res['request_id']!r}")
+        if not res["keyframe"]:
+            deltas[res["config_hash"]] = deltas.get(res["config_hash"], 0) + 1
+
+        if res["max_error_db"] == 0.0:
+            err = np.max(np.abs(pxx - ref.astype(np.float32)))
+            if err != 0.0:
+                errors.append(f"frame {idx}: float32 payload off by {err:g}")
+            continue
+
+        mask = np.isfinite(ref) & (np.abs(ref) < 1e6)
+        if res["clipped"] == bool(np.all(mask)):
+            errors.append(f"frame {idx}: clipped flag {res['clipped']} does not match the trace")
+        bound = res["max_error_db"] * (1.0 + 1e-6) + 1e-9
+        err = np.max(np.abs(pxx[mask] - ref[mask]))
+        if err > bound:
+            errors.append(f"frame {idx}: error {err:.6f} dB above bound {bound:.6f} dB")
+
+    if count == 0:
+        errors.append("no frames produced")
+    if len(deltas) < 2:
+        errors.append(f"delta frames for {len(deltas)} config(s), expected both interleaved configs")
+    return errors
+
+
+def main() -> int:
+    if len(sys.argv) < 2:
+        print(__doc__.strip().splitlines()[-2])
+        return 2
+    bins = int(sys.argv[2]) if len(sys.argv) > 2 else 4096
+    errors = check(sys.argv[1], bins)
+    for e in errors:
+        print(f"[psd_wire_check] {e}")
+    print(f"[psd_wire_check] {'FAIL' if errors else 'OK'} ({bins} bins)")
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -175,8 +175,13 @@ class ZmqSub:
 
     async def wait_msg(self):
         while True:
-            full_msg = await self.socket.recv_string()
-            pub_topic, json_msg = full_msg.split(" ", 1)
+            # [topic][json] frames, or a single "topic json" frame
+            # (legacy / publisher in conflate mode)
+            frames = await self.socket.recv_multipart()
+            if len(frames) >= 2:
+                pub_topic, json_msg = frames[0].decode("utf-8"), frames[-1].decode("utf-8")
+            else:
+                pub_topic, json_msg = frames[0].decode("utf-8").split(" ", 1)
 
             if pub_topic == self.topic:
                 if self.verbose: